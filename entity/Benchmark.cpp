@@ -0,0 +1,370 @@
+#include "Benchmark.h"
+
+#include <grpcpp/client_context.h>
+#include <grpcpp/generic/generic_stub.h>
+
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <cmath>
+
+#include "CallEngine.h"
+
+// これより遅いレスポンスは最大値として記録する
+static constexpr int64_t HIGHEST_TRACKABLE_LATENCY_US = INT64_C(3600) * 1000 * 1000;
+
+// OpenLoopの送信予定時刻の直前は、スリープの誤差を避けるためにスピンして待つ
+static constexpr auto PACER_SPIN_THRESHOLD = std::chrono::microseconds(500);
+
+class Benchmark::Caller : public CallEngine::Tag {
+public:
+    explicit Caller(Benchmark &benchmark)
+        : benchmark(benchmark), queue(CallEngine::shared().assignQueue()), stub(benchmark.channel) {}
+
+    /**
+     * 停止済みなら何もせずにfalseを返す。stop()はstoppedを立ててからcancel()するので、ロックの中で確かめれば
+     * 作ったContextが取り消されずに残ることはない
+     */
+    bool startCall(std::chrono::steady_clock::time_point intendedTime) {
+        QMutexLocker locker(&contextLock);
+        if (benchmark.stopped) {
+            return false;
+        }
+        unaryCall.reset();
+        streamingCall.reset();
+        context = std::make_unique<grpc::ClientContext>();
+        for (const auto &[key, value] : benchmark.metadata) {
+            context->AddMetadata(key, value);
+        }
+
+        callIntendedTime = intendedTime;
+        benchmark.startedRequests.fetch_add(1, std::memory_order_relaxed);
+        if (benchmark.streaming) {
+            streamingCall = stub.PrepareCall(context.get(), benchmark.requestPath, queue);
+            state = State::Starting;
+            streamingCall->StartCall(this);
+        } else {
+            unaryCall = stub.PrepareUnaryCall(context.get(), benchmark.requestPath, benchmark.request, queue);
+            unaryCall->StartCall();
+            state = State::Finishing;
+            unaryCall->Finish(&responseBuffer, &status, this);
+        }
+        return true;
+    }
+
+    void cancel() {
+        QMutexLocker locker(&contextLock);
+        if (context) {
+            context->TryCancel();
+        }
+    }
+
+    void proceed(bool ok) override {
+        switch (state) {
+            case State::Starting:
+                if (!ok) {
+                    finishStreamingCall();
+                    break;
+                }
+                state = State::Writing;
+                streamingCall->WriteLast(benchmark.request, grpc::WriteOptions(), this);
+                break;
+            case State::Writing:
+                if (!ok) {
+                    finishStreamingCall();
+                    break;
+                }
+                state = State::Reading;
+                streamingCall->Read(&responseBuffer, this);
+                break;
+            case State::Reading:
+                if (ok) {
+                    streamingCall->Read(&responseBuffer, this);
+                } else {
+                    finishStreamingCall();
+                }
+                break;
+            case State::Finishing:
+                benchmark.onCallFinished(*this, callIntendedTime, status.error_code());
+                break;
+        }
+    }
+
+private:
+    enum class State {
+        Starting,
+        Writing,
+        Reading,
+        Finishing,
+    };
+
+    Benchmark &benchmark;
+    grpc::CompletionQueue *queue;
+    grpc::GenericStub stub;
+    QMutex contextLock;
+    std::unique_ptr<grpc::ClientContext> context;
+    std::unique_ptr<grpc::GenericClientAsyncResponseReader> unaryCall;
+    std::unique_ptr<grpc::GenericClientAsyncReaderWriter> streamingCall;
+    State state = State::Starting;
+    std::chrono::steady_clock::time_point callIntendedTime;
+    grpc::ByteBuffer responseBuffer;
+    grpc::Status status;
+
+    void finishStreamingCall() {
+        state = State::Finishing;
+        streamingCall->Finish(&status, this);
+    }
+};
+
+Benchmark::Benchmark(const Method &method, std::shared_ptr<grpc::Channel> channel, const Session::Metadata &metadata,
+                     const grpc::ByteBuffer &request, const Options &options, QObject *parent)
+    : QObject(parent),
+      channel(std::move(channel)),
+      requestPath(method.getRequestPath()),
+      streaming(method.isClientStreaming() || method.isServerStreaming()),
+      request(request),
+      options(options),
+      histogram(HIGHEST_TRACKABLE_LATENCY_US),
+      issuedRequests(0),
+      startedRequests(0),
+      stopped(false),
+      pacerRunning(false),
+      busyCallers(0) {
+    for (auto iter = metadata.cbegin(); iter != metadata.cend(); iter++) {
+        this->metadata.emplace_back(iter.key().toStdString(), iter.value().toStdString());
+    }
+    for (auto &count : statusCounts) {
+        count = 0;
+    }
+    for (int i = 0; i < std::max(1, options.concurrency); i++) {
+        callers.push_back(std::make_unique<Caller>(*this));
+    }
+}
+
+Benchmark::~Benchmark() {
+    stop();
+    if (pacer) {
+        pacer->wait();
+    }
+    QMutexLocker locker(&runningLock);
+    while (busyCallers > 0) {
+        callersStopped.wait(&runningLock);
+    }
+}
+
+void Benchmark::start() {
+    QMutexLocker locker(&runningLock);
+    if (busyCallers > 0 || pacerRunning) {
+        return;
+    }
+    beginTime = std::chrono::steady_clock::now();
+    endTime = beginTime;
+    idleCallers.clear();
+    for (auto &caller : callers) {
+        idleCallers.push_back(caller.get());
+    }
+
+    if (options.mode == Mode::OpenLoop) {
+        pacerRunning = true;
+        pacer.reset(QThread::create([this]() { runPacer(); }));
+        pacer->setObjectName("Benchmark Pacer");
+        pacer->start(QThread::TimeCriticalPriority);
+        return;
+    }
+
+    std::vector<Caller *> startingCallers;
+    while (!idleCallers.empty() && acquireTicket()) {
+        startingCallers.push_back(idleCallers.back());
+        idleCallers.pop_back();
+    }
+    busyCallers = static_cast<int>(startingCallers.size());
+    locker.unlock();
+
+    if (startingCallers.empty()) {
+        emit finished();
+        return;
+    }
+    for (auto caller : startingCallers) {
+        if (!caller->startCall(std::chrono::steady_clock::now())) {
+            releaseCaller(*caller);
+        }
+    }
+}
+
+void Benchmark::stop() {
+    stopped = true;
+    {
+        QMutexLocker locker(&runningLock);
+        pacerWakeup.wakeAll();
+    }
+    for (auto &caller : callers) {
+        caller->cancel();
+    }
+}
+
+bool Benchmark::isRunning() {
+    QMutexLocker locker(&runningLock);
+    return busyCallers > 0 || pacerRunning;
+}
+
+int64_t Benchmark::getStatusCount(grpc::StatusCode code) const {
+    if (code < 0 || static_cast<size_t>(code) >= statusCounts.size()) {
+        return 0;
+    }
+    return statusCounts[code].load(std::memory_order_relaxed);
+}
+
+double Benchmark::getTargetRate() {
+    if (options.mode != Mode::OpenLoop) {
+        return 0;
+    }
+    const double duration = std::chrono::duration<double>(options.duration).count();
+    if (options.rampRate <= 0 || duration <= 0) {
+        return options.rate;
+    }
+    const double elapsed = std::min(std::chrono::duration<double>(getElapsed()).count(), duration);
+    return options.rate + (options.rampRate - options.rate) * elapsed / duration;
+}
+
+std::chrono::steady_clock::duration Benchmark::getElapsed() {
+    QMutexLocker locker(&runningLock);
+    const auto running = busyCallers > 0 || pacerRunning;
+    return (running ? std::chrono::steady_clock::now() : endTime) - beginTime;
+}
+
+void Benchmark::runPacer() {
+    for (int64_t i = 0;; i++) {
+        std::chrono::steady_clock::time_point intendedTime;
+        if (!scheduledTime(i, intendedTime)) {
+            break;
+        }
+
+        {
+            QMutexLocker locker(&runningLock);
+            while (!stopped && std::chrono::steady_clock::now() < intendedTime - PACER_SPIN_THRESHOLD) {
+                pacerWakeup.wait(&runningLock, QDeadlineTimer(intendedTime - PACER_SPIN_THRESHOLD, Qt::PreciseTimer));
+            }
+        }
+        while (!stopped && std::chrono::steady_clock::now() < intendedTime) {
+            QThread::yieldCurrentThread();
+        }
+        if (stopped) {
+            break;
+        }
+
+        issuedRequests++;
+        Caller *caller = nullptr;
+        {
+            QMutexLocker locker(&runningLock);
+            if (idleCallers.empty()) {
+                // 全て処理中なので、空きができ次第送信する。遅れた分もレイテンシに含まれる。
+                backlog.push_back(intendedTime);
+            } else {
+                caller = idleCallers.back();
+                idleCallers.pop_back();
+                busyCallers++;
+            }
+        }
+        if (caller != nullptr && !caller->startCall(intendedTime)) {
+            releaseCaller(*caller);
+        }
+    }
+
+    QMutexLocker locker(&runningLock);
+    pacerRunning = false;
+    if (stopped) {
+        backlog.clear();
+    }
+    finishIfIdle();
+}
+
+bool Benchmark::scheduledTime(int64_t index, std::chrono::steady_clock::time_point &time) const {
+    if (options.requests > 0 && index >= options.requests) {
+        return false;
+    }
+
+    const double duration = std::chrono::duration<double>(options.duration).count();
+    double seconds;
+    if (options.rampRate > 0 && duration > 0) {
+        // 送信数 N(t) = rate * t + (rampRate - rate) * t^2 / (2 * duration) を t について解く
+        const double a = (options.rampRate - options.rate) / (2 * duration);
+        if (std::abs(a) < 1e-12) {
+            seconds = index / options.rate;
+        } else {
+            const double discriminant = options.rate * options.rate + 4 * a * index;
+            if (discriminant < 0) {
+                return false;
+            }
+            seconds = (-options.rate + std::sqrt(discriminant)) / (2 * a);
+        }
+    } else {
+        if (options.rate <= 0) {
+            return false;
+        }
+        seconds = index / options.rate;
+    }
+    if (duration > 0 && seconds >= duration) {
+        return false;
+    }
+
+    time = beginTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                           std::chrono::duration<double>(seconds));
+    return true;
+}
+
+bool Benchmark::acquireTicket() {
+    if (stopped) {
+        return false;
+    }
+    if (options.duration.count() > 0 && std::chrono::steady_clock::now() - beginTime >= options.duration) {
+        return false;
+    }
+    if (options.requests > 0 && issuedRequests.fetch_add(1) >= options.requests) {
+        return false;
+    }
+    return true;
+}
+
+void Benchmark::onCallFinished(Caller &caller, std::chrono::steady_clock::time_point intendedTime,
+                               grpc::StatusCode code) {
+    const auto latency = std::chrono::steady_clock::now() - intendedTime;
+    histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    if (code < 0 || static_cast<size_t>(code) >= statusCounts.size()) {
+        code = grpc::StatusCode::UNKNOWN;
+    }
+    statusCounts[code].fetch_add(1, std::memory_order_relaxed);
+
+    if (options.mode == Mode::ClosedLoop) {
+        if (acquireTicket() && caller.startCall(std::chrono::steady_clock::now())) {
+            return;
+        }
+    } else {
+        QMutexLocker locker(&runningLock);
+        if (!stopped && !backlog.empty()) {
+            const auto nextIntendedTime = backlog.front();
+            backlog.pop_front();
+            locker.unlock();
+            if (caller.startCall(nextIntendedTime)) {
+                return;
+            }
+        }
+    }
+
+    releaseCaller(caller);
+}
+
+void Benchmark::releaseCaller(Caller &caller) {
+    QMutexLocker locker(&runningLock);
+    idleCallers.push_back(&caller);
+    busyCallers--;
+    finishIfIdle();
+}
+
+void Benchmark::finishIfIdle() {
+    // Called on the pacer or the engine's poller threads, so finished() is delivered as a queued signal. It's emitted
+    // while the caller holds runningLock so that the destructor can't run in between.
+    if (busyCallers == 0 && !pacerRunning) {
+        endTime = std::chrono::steady_clock::now();
+        emit finished();
+        callersStopped.wakeAll();
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef FLORARPC_BENCHMARK_H
+#define FLORARPC_BENCHMARK_H
+
+#include <grpcpp/channel.h>
+#include <grpcpp/support/byte_buffer.h>
+#include <grpcpp/support/status.h>
+
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QWaitCondition>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Method.h"
+#include "Session.h"
+#include "util/LatencyHistogram.h"
+
+/**
+ * 同じリクエストを繰り返し送信し、レイテンシを計測する
+ */
+class Benchmark : public QObject {
+    Q_OBJECT
+
+    Q_DISABLE_COPY(Benchmark)
+
+public:
+    enum class Mode {
+        // 並列数ぶんの呼び出しを、完了し次第すぐに次を送信する
+        ClosedLoop,
+        // 応答を待たずに、指定したレートで送信する
+        OpenLoop,
+    };
+
+    struct Options {
+        Mode mode = Mode::ClosedLoop;
+        // ClosedLoopでは並列数、OpenLoopでは同時に処理中にできる呼び出しの上限
+        int concurrency = 1;
+        // 0なら回数を制限しない
+        int64_t requests = 0;
+        // 0なら時間を制限しない
+        std::chrono::milliseconds duration = std::chrono::milliseconds::zero();
+        // OpenLoopの送信レート (req/s)
+        double rate = 0;
+        // 0より大きければ、実行時間をかけてrateからこのレートまで線形に変化させる (OpenLoopのみ)
+        double rampRate = 0;
+    };
+
+    Benchmark(const Method &method, std::shared_ptr<grpc::Channel> channel, const Session::Metadata &metadata,
+              const grpc::ByteBuffer &request, const Options &options, QObject *parent = nullptr);
+
+    ~Benchmark() override;
+
+    void start();
+
+    void stop();
+
+    bool isRunning();
+
+    inline const Options &getOptions() const { return options; }
+
+    /**
+     * レイテンシのヒストグラム (マイクロ秒)。
+     * OpenLoopでは、実際に送信した時刻ではなく送信する予定だった時刻から計測する。
+     */
+    inline const LatencyHistogram &getHistogram() const { return histogram; }
+
+    int64_t getStatusCount(grpc::StatusCode code) const;
+
+    /**
+     * 送信した (OpenLoopでは送信を予定した) リクエスト数
+     */
+    inline int64_t getIssuedCount() const { return issuedRequests; }
+
+    /**
+     * 実際に送信を始めたリクエスト数。OpenLoopで呼び出しの空きを待っているものは含まない
+     */
+    inline int64_t getStartedCount() const { return startedRequests.load(std::memory_order_relaxed); }
+
+    /**
+     * 現時点での目標レート (req/s)。ClosedLoopでは0。
+     */
+    double getTargetRate();
+
+    std::chrono::steady_clock::duration getElapsed();
+
+signals:
+
+    void finished();
+
+private:
+    class Caller;
+
+    const std::shared_ptr<grpc::Channel> channel;
+    const std::string requestPath;
+    const bool streaming;
+    std::vector<std::pair<std::string, std::string>> metadata;
+    const grpc::ByteBuffer request;
+    const Options options;
+
+    std::vector<std::unique_ptr<Caller>> callers;
+    LatencyHistogram histogram;
+    std::array<std::atomic<int64_t>, grpc::StatusCode::UNAUTHENTICATED + 1> statusCounts;
+    std::atomic<int64_t> issuedRequests;
+    std::atomic<int64_t> startedRequests;
+    std::atomic<bool> stopped;
+
+    std::unique_ptr<QThread> pacer;
+    bool pacerRunning;
+    std::vector<Caller *> idleCallers;
+    std::deque<std::chrono::steady_clock::time_point> backlog;
+    int busyCallers;
+    std::chrono::steady_clock::time_point beginTime;
+    std::chrono::steady_clock::time_point endTime;
+    QMutex runningLock;
+    QWaitCondition callersStopped;
+    QWaitCondition pacerWakeup;
+
+    void runPacer();
+
+    bool scheduledTime(int64_t index, std::chrono::steady_clock::time_point &time) const;
+
+    bool acquireTicket();
+
+    void onCallFinished(Caller &caller, std::chrono::steady_clock::time_point intendedTime, grpc::StatusCode code);
+
+    void releaseCaller(Caller &caller);
+
+    void finishIfIdle();
+
+    friend Caller;
+};
+
+#endif  // FLORARPC_BENCHMARK_H
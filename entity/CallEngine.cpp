@@ -0,0 +1,39 @@
+#include "CallEngine.h"
+
+#include <algorithm>
+
+CallEngine &CallEngine::shared() {
+    static CallEngine engine;
+    return engine;
+}
+
+CallEngine::CallEngine() : nextPoller(0) {
+    const auto count = std::max(1, QThread::idealThreadCount());
+    for (int i = 0; i < count; i++) {
+        auto poller = std::make_unique<Poller>();
+        auto queue = &poller->queue;
+        poller->thread.reset(QThread::create([queue]() {
+            void *tag;
+            bool ok;
+            while (queue->Next(&tag, &ok)) {
+                static_cast<Tag *>(tag)->proceed(ok);
+            }
+        }));
+        poller->thread->setObjectName(QString("CallEngine Poller #%1").arg(i));
+        poller->thread->start();
+        pollers.push_back(std::move(poller));
+    }
+}
+
+CallEngine::~CallEngine() {
+    for (auto &poller : pollers) {
+        poller->queue.Shutdown();
+    }
+    for (auto &poller : pollers) {
+        poller->thread->wait();
+    }
+}
+
+grpc::CompletionQueue *CallEngine::assignQueue() {
+    return &pollers[nextPoller++ % pollers.size()]->queue;
+}
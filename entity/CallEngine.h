@@ -0,0 +1,48 @@
+#ifndef FLORARPC_CALLENGINE_H
+#define FLORARPC_CALLENGINE_H
+
+#include <grpcpp/completion_queue.h>
+
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * 全Sessionで共有するCompletionQueueとポーリングスレッドのプール
+ */
+class CallEngine {
+public:
+    /**
+     * CompletionQueueに渡すタグ。イベントはタグ自身に配送されるので、ディスパッチにロックは要らない。
+     */
+    class Tag {
+    public:
+        virtual ~Tag() = default;
+
+        virtual void proceed(bool ok) = 0;
+    };
+
+    static CallEngine &shared();
+
+    ~CallEngine();
+
+    /**
+     * 新しい呼び出しに割り当てるCompletionQueueを返す。
+     * 1つの呼び出しのイベントは常に同じスレッドで処理される。
+     */
+    grpc::CompletionQueue *assignQueue();
+
+private:
+    struct Poller {
+        grpc::CompletionQueue queue;
+        std::unique_ptr<QThread> thread;
+    };
+
+    CallEngine();
+
+    std::vector<std::unique_ptr<Poller>> pollers;
+    std::atomic<size_t> nextPoller;
+};
+
+#endif  // FLORARPC_CALLENGINE_H
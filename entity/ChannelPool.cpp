@@ -0,0 +1,99 @@
+#include "ChannelPool.h"
+
+#include <grpcpp/create_channel.h>
+#include <grpcpp/security/credentials.h>
+
+#include <QDebug>
+#include <QMutexLocker>
+
+// 他から参照されていないChannelがこの時間使われなければ破棄する
+static constexpr auto IDLE_TIMEOUT = std::chrono::minutes(5);
+
+static QString makeKey(const Server &server, const std::shared_ptr<Certificate> &certificate) {
+    QStringList key;
+    key << server.address << (server.useTLS ? "tls" : "insecure");
+    if (server.useTLS) {
+        key << server.tlsTargetNameOverride;
+        if (certificate) {
+            key << certificate->id.toString() << certificate->rootCertsPath << certificate->privateKeyPath
+                << certificate->certChainPath;
+        }
+    }
+    return key.join('\n');
+}
+
+static std::shared_ptr<grpc::ChannelCredentials> getCredentials(const Server &server,
+                                                                const std::shared_ptr<Certificate> &certificate) {
+    if (server.useTLS) {
+        if (certificate) {
+            qDebug() << "Using ssl channel credentials with user options";
+            return certificate->getCredentials();
+        } else {
+            qDebug() << "Using default ssl channel credentials";
+            return grpc::SslCredentials(grpc::SslCredentialsOptions());
+        }
+    } else {
+        qDebug() << "Using insecure channel credentials";
+        return grpc::InsecureChannelCredentials();
+    }
+}
+
+static grpc::ChannelArguments getChannelArguments(const Server &server) {
+    grpc::ChannelArguments args;
+    if (server.useTLS && !server.tlsTargetNameOverride.isEmpty()) {
+        args.SetSslTargetNameOverride(server.tlsTargetNameOverride.toStdString());
+    }
+    return args;
+}
+
+ChannelPool &ChannelPool::shared() {
+    static ChannelPool pool;
+    return pool;
+}
+
+ChannelPool::ChannelPool(QObject *parent) : QObject(parent), evictionTimer(this) {
+    connect(&evictionTimer, &QTimer::timeout, this, &ChannelPool::evictIdleChannels);
+    evictionTimer.start(std::chrono::minutes(1));
+}
+
+std::shared_ptr<grpc::Channel> ChannelPool::acquire(const Server &server,
+                                                    const std::vector<std::shared_ptr<Certificate>> &certificates) {
+    const auto certificate = server.findCertificate(certificates);
+    const auto key = makeKey(server, certificate);
+
+    QMutexLocker locker(&lock);
+    auto iter = channels.find(key);
+    if (iter == channels.end()) {
+        qDebug() << "Create new channel for" << server.address;
+        Entry entry;
+        entry.channel = grpc::CreateCustomChannel(server.address.toStdString(), getCredentials(server, certificate),
+                                                  getChannelArguments(server));
+        iter = channels.insert(key, entry);
+    }
+    iter->lastUsed = std::chrono::steady_clock::now();
+    return iter->channel;
+}
+
+void ChannelPool::reconnect(const Server &server, const std::vector<std::shared_ptr<Certificate>> &certificates) {
+    const auto key = makeKey(server, server.findCertificate(certificates));
+
+    QMutexLocker locker(&lock);
+    channels.remove(key);
+}
+
+void ChannelPool::evictIdleChannels() {
+    const auto now = std::chrono::steady_clock::now();
+
+    QMutexLocker locker(&lock);
+    for (auto iter = channels.begin(); iter != channels.end();) {
+        // use_count() > 1 means some session is still using this channel
+        if (iter->channel.use_count() > 1) {
+            iter->lastUsed = now;
+            ++iter;
+        } else if (now - iter->lastUsed > IDLE_TIMEOUT) {
+            iter = channels.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef FLORARPC_CHANNELPOOL_H
+#define FLORARPC_CHANNELPOOL_H
+
+#include <grpcpp/channel.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Certificate.h"
+#include "Server.h"
+
+/**
+ * 接続先ごとにChannelを使い回すためのキャッシュ
+ */
+class ChannelPool : public QObject {
+    Q_OBJECT
+
+    Q_DISABLE_COPY(ChannelPool)
+
+public:
+    static ChannelPool &shared();
+
+    /**
+     * 接続先に対応するChannelを返す。キャッシュに無ければ作成する。
+     */
+    std::shared_ptr<grpc::Channel> acquire(const Server &server,
+                                           const std::vector<std::shared_ptr<Certificate>> &certificates);
+
+    /**
+     * 接続先のChannelを破棄し、次回のacquireで接続し直すようにする。
+     */
+    void reconnect(const Server &server, const std::vector<std::shared_ptr<Certificate>> &certificates);
+
+private slots:
+
+    void evictIdleChannels();
+
+private:
+    struct Entry {
+        std::shared_ptr<grpc::Channel> channel;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    explicit ChannelPool(QObject *parent = nullptr);
+
+    QHash<QString, Entry> channels;
+    QMutex lock;
+    QTimer evictionTimer;
+};
+
+#endif  // FLORARPC_CHANNELPOOL_H
@@ -3,9 +3,12 @@
 #include <google/protobuf/dynamic_message.h>
 #include <google/protobuf/util/json_util.h>
 
+#include <memory>
 #include <sstream>
 
 #include "../util/GrpcUtility.h"
+#include "../util/JsonMessageParser.h"
+#include "../util/JsonMessagePrinter.h"
 #include "../util/ProtobufJsonPrinter.h"
 #include "google/rpc/status.pb.h"
 
@@ -26,30 +29,41 @@ std::string Method::makeRequestSkeleton() {
     return ProtobufJsonPrinter::makeRequestSkeleton(descriptor->input_type());
 }
 
-std::unique_ptr<google::protobuf::Message>
-Method::parseRequest(google::protobuf::DynamicMessageFactory &factory, const std::string &json) {
-    auto reqProto = factory.GetPrototype(descriptor->input_type());
-    auto reqMessage = std::unique_ptr<google::protobuf::Message>(reqProto->New());
+google::protobuf::Message *Method::parseRequest(const std::string &json, google::protobuf::Arena &arena) {
+    auto reqProto = protocol->getMessageFactory().GetPrototype(descriptor->input_type());
+    auto reqMessage = reqProto->New(&arena);
+
+    if (!requestParser) {
+        requestParser = std::make_shared<const JsonMessageParser>(descriptor->input_type());
+    }
+    if (requestParser->parse(json, *reqMessage)) {
+        return reqMessage;
+    }
+
+    // 扱えない入力は汎用のパーサーで読み直す。エラーメッセージもこちらのものを使う
+    reqMessage->Clear();
     google::protobuf::util::JsonParseOptions parseOptions;
     parseOptions.ignore_unknown_fields = true;
     parseOptions.case_insensitive_enum_parsing = true;
-    auto parseStatus = google::protobuf::util::JsonStringToMessage(json, reqMessage.get(), parseOptions);
+    auto parseStatus = google::protobuf::util::JsonStringToMessage(json, reqMessage, parseOptions);
     if (!parseStatus.ok()) {
         throw ParseError(std::make_unique<std::string>(parseStatus.message()));
     }
     return reqMessage;
 }
 
-std::unique_ptr<google::protobuf::Message> Method::parseResponse(google::protobuf::DynamicMessageFactory &factory,
-                                                                 const grpc::ByteBuffer &buffer) {
-    auto resProto = factory.GetPrototype(descriptor->output_type());
-    auto resMessage = std::unique_ptr<google::protobuf::Message>(resProto->New());
+google::protobuf::Message *Method::parseResponse(const grpc::ByteBuffer &buffer, google::protobuf::Arena &arena,
+                                                 const ResponseProjection *projection) {
+    if (projection != nullptr) {
+        return projection->parse(buffer, arena);
+    }
+    auto resProto = protocol->getMessageFactory().GetPrototype(descriptor->output_type());
+    auto resMessage = resProto->New(&arena);
     GrpcUtility::parseMessage(buffer, *resMessage);
     return resMessage;
 }
 
-std::unique_ptr<google::protobuf::Message> Method::parseErrorDetails(google::protobuf::DynamicMessageFactory &factory,
-                                                                     const std::string &buffer) {
+google::protobuf::Message *Method::parseErrorDetails(const std::string &buffer, google::protobuf::Arena &arena) {
     auto pool = protocol->getFileDescriptor()->pool();
     // import proto file
     {
@@ -60,8 +74,8 @@ std::unique_ptr<google::protobuf::Message> Method::parseErrorDetails(google::pro
     auto desc = pool->FindMessageTypeByName("google.rpc.Status");
     if (desc != nullptr) {
         // parse message using method's descriptor pool
-        auto proto = factory.GetPrototype(desc);
-        auto message = std::unique_ptr<google::protobuf::Message>(proto->New());
+        auto proto = protocol->getMessageFactory().GetPrototype(desc);
+        auto message = proto->New(&arena);
         if (message->ParseFromString(buffer)) {
             return message;
         } else {
@@ -69,7 +83,7 @@ std::unique_ptr<google::protobuf::Message> Method::parseErrorDetails(google::pro
         }
     } else {
         // fallback, retry with default descriptor pool
-        auto message = std::make_unique<google::rpc::Status>();
+        auto message = google::protobuf::Arena::CreateMessage<google::rpc::Status>(&arena);
         if (message->ParseFromString(buffer)) {
             return message;
         } else {
@@ -78,6 +92,33 @@ std::unique_ptr<google::protobuf::Message> Method::parseErrorDetails(google::pro
     }
 }
 
+QString Method::formatResponse(const google::protobuf::Message &message, int maxLength, bool &truncated,
+                               const ResponseProjection *projection) {
+    // ワーカースレッドからも呼ばれる。同時に作られても、どちらか一方が残るだけで害は無い
+    auto printer = std::atomic_load(&responsePrinter);
+    if (!printer) {
+        printer = std::make_shared<const JsonMessagePrinter>(descriptor->output_type());
+        std::atomic_store(&responsePrinter, printer);
+    }
+    QString out;
+    if ((projection != nullptr ? projection->getPrinter() : *printer).print(message, out, maxLength, truncated)) {
+        return out;
+    }
+
+    // 扱えないメッセージは汎用の変換に任せる
+    std::string json;
+    google::protobuf::util::JsonOptions opts;
+    opts.add_whitespace = true;
+    opts.always_print_primitive_fields = true;
+    google::protobuf::util::MessageToJsonString(message, &json, opts);
+    out = QString::fromStdString(json);
+    truncated = out.size() > maxLength;
+    if (truncated) {
+        out.truncate(maxLength);
+    }
+    return out;
+}
+
 void Method::writeMethodRef(florarpc::MethodRef &ref) {
     ref.set_service_name(descriptor->service()->full_name());
     ref.set_method_name(descriptor->name());
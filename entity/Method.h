@@ -1,15 +1,21 @@
 #ifndef FLORARPC_METHOD_H
 #define FLORARPC_METHOD_H
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/dynamic_message.h>
 #include <grpcpp/support/byte_buffer.h>
 
+#include <QString>
+
 #include "Protocol.h"
+#include "ResponseProjection.h"
 #include "florarpc/descriptor_exports.pb.h"
 #include "florarpc/workspace.pb.h"
 
 class DescriptorPoolProxy;
+class JsonMessageParser;
+class JsonMessagePrinter;
 
 class Method {
 public:
@@ -33,16 +39,29 @@ public:
 
     inline bool isServerStreaming() const { return descriptor->server_streaming(); }
 
+    inline const google::protobuf::Descriptor *getResponseType() const { return descriptor->output_type(); }
+
     std::string makeRequestSkeleton();
 
-    std::unique_ptr<google::protobuf::Message> parseRequest(google::protobuf::DynamicMessageFactory &factory,
-                                                            const std::string &json);
+    /**
+     * 返すメッセージはarenaの所有物で、arenaと一緒にまとめて解放される (parseResponse, parseErrorDetailsも同じ)
+     */
+    google::protobuf::Message *parseRequest(const std::string &json, google::protobuf::Arena &arena);
+
+    /**
+     * projectionがあれば、選ばれたフィールドだけを持つ型でデコードする
+     */
+    google::protobuf::Message *parseResponse(const grpc::ByteBuffer &buffer, google::protobuf::Arena &arena,
+                                             const ResponseProjection *projection = nullptr);
 
-    std::unique_ptr<google::protobuf::Message> parseResponse(google::protobuf::DynamicMessageFactory &factory,
-                                                             const grpc::ByteBuffer &buffer);
+    google::protobuf::Message *parseErrorDetails(const std::string &buffer, google::protobuf::Arena &arena);
 
-    std::unique_ptr<google::protobuf::Message> parseErrorDetails(google::protobuf::DynamicMessageFactory &factory,
-                                                                 const std::string &buffer);
+    /**
+     * レスポンスを表示用のJSONにする。maxLength文字を超える分は切り捨て、truncatedをtrueにする
+     * parseResponseと同じく、複数のスレッドから同時に呼んでよい。projectionはparseResponseに渡したものと同じにする
+     */
+    QString formatResponse(const google::protobuf::Message &message, int maxLength, bool &truncated,
+                           const ResponseProjection *projection = nullptr);
 
     void writeMethodRef(florarpc::MethodRef &ref);
 
@@ -53,6 +72,10 @@ public:
 private:
     const std::shared_ptr<Protocol> protocol;
     const google::protobuf::MethodDescriptor *descriptor;
+    // 初回のparseRequestで作る。Methodのコピー間で共有してよい
+    std::shared_ptr<const JsonMessageParser> requestParser;
+    // 初回のformatResponseで作る。スレッド間で共有するので、読み書きはstd::atomic_load/storeで行う
+    std::shared_ptr<const JsonMessagePrinter> responsePrinter;
 
     friend DescriptorPoolProxy;
 };
@@ -51,6 +51,7 @@ Protocol::Protocol(const QFileInfo &file, const QStringList &imports) : source(f
     errorCollector = move(errorCollectorStub);
     sourceTree = move(wellKnownSourceTree);
     fileDescriptor = fd;
+    messageFactory = std::make_unique<google::protobuf::DynamicMessageFactory>();
 }
 
 const google::protobuf::MethodDescriptor *Protocol::findMethodByRef(const florarpc::MethodRef &ref) {
@@ -71,5 +72,16 @@ const google::protobuf::MethodDescriptor *Protocol::findMethodByRef(const florar
     return nullptr;
 }
 
+void Protocol::warmUpPrototypes() const {
+    ProtobufIterator::Iterable<const FileDescriptor, const ServiceDescriptor> services(fileDescriptor);
+    for (const auto &service : services) {
+        ProtobufIterator::Iterable<const ServiceDescriptor, const MethodDescriptor> methods(service);
+        for (const auto &method : methods) {
+            messageFactory->GetPrototype(method->input_type());
+            messageFactory->GetPrototype(method->output_type());
+        }
+    }
+}
+
 ProtocolLoadException::ProtocolLoadException(std::unique_ptr<std::vector<std::string>> errors)
     : std::exception(), errors(move(errors)) {}
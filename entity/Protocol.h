@@ -2,6 +2,7 @@
 #define FLORARPC_PROTOCOL_H
 
 #include <google/protobuf/compiler/importer.h>
+#include <google/protobuf/dynamic_message.h>
 
 #include <QFileInfo>
 #include <memory>
@@ -18,14 +19,27 @@ public:
 
     inline const google::protobuf::FileDescriptor *getFileDescriptor() const { return fileDescriptor; };
 
+    /**
+     * このProtocolのDescriptorPool用のファクトリ。Messageを生成するたびに作り直さずに使い回す
+     * GetPrototypeはスレッドセーフ
+     */
+    inline google::protobuf::DynamicMessageFactory &getMessageFactory() const { return *messageFactory; }
+
     const google::protobuf::MethodDescriptor *findMethodByRef(const florarpc::MethodRef &ref);
 
+    /**
+     * 全メソッドのリクエストとレスポンスのプロトタイプを先に生成しておく
+     */
+    void warmUpPrototypes() const;
+
 private:
     const QFileInfo source;
     std::unique_ptr<google::protobuf::compiler::SourceTree> sourceTree;
     std::unique_ptr<google::protobuf::compiler::Importer> importer;
     std::unique_ptr<google::protobuf::compiler::MultiFileErrorCollector> errorCollector;
     const google::protobuf::FileDescriptor *fileDescriptor;
+    // プロトタイプがimporterのDescriptorを参照しているので、importerより後に宣言して先に破棄させる
+    std::unique_ptr<google::protobuf::DynamicMessageFactory> messageFactory;
 };
 
 class ProtocolLoadException : public std::exception {
@@ -0,0 +1,435 @@
+#include "ResponseDiff.h"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/text_format.h>
+#include <google/protobuf/util/field_comparator.h>
+#include <google/protobuf/util/json_util.h>
+#include <google/protobuf/util/message_differencer.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include "util/ProtobufField.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+using google::protobuf::util::DefaultFieldComparator;
+using google::protobuf::util::MessageDifferencer;
+
+using FieldPath = std::vector<const FieldDescriptor *>;
+
+// 木に入れる節の数。大きなrepeatedフィールドが丸ごと違っていても、表示が固まらないようにする
+static constexpr int maxNodes = 10000;
+// 値の列に出す文字数
+static constexpr int maxValueLength = 1000;
+
+/**
+ * "a.b.c" をフィールドの並びにする。repeatedなメッセージも辿る。見つからなければ空
+ */
+static FieldPath resolvePath(const Descriptor *type, const QString &path) {
+    FieldPath fields;
+    for (const auto &part : path.trimmed().split('.')) {
+        const FieldDescriptor *field = nullptr;
+        if (type != nullptr) {
+            field = ProtobufField::findField(type, part.trimmed().toStdString());
+        }
+        if (field == nullptr) {
+            return {};
+        }
+        fields.push_back(field);
+        type = field->message_type();
+    }
+    return fields;
+}
+
+/**
+ * キーで突き合わせられるrepeatedフィールドと、その要素の中のキーのパス
+ */
+static bool resolveKey(const Descriptor *type, const QString &spec, const FieldDescriptor *&field, FieldPath &key) {
+    const auto parts = spec.split('=');
+    if (parts.size() != 2) {
+        return false;
+    }
+    const auto path = resolvePath(type, parts[0]);
+    // mapは元からキーで突き合わせる
+    if (path.empty() || !path.back()->is_repeated() || path.back()->is_map() ||
+        path.back()->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+        return false;
+    }
+    key = resolvePath(path.back()->message_type(), parts[1]);
+    if (key.empty() || std::any_of(key.begin(), key.end(), [](auto f) { return f->is_repeated(); })) {
+        return false;
+    }
+    field = path.back();
+    return true;
+}
+
+static QString truncate(QString text) {
+    if (text.size() > maxValueLength) {
+        text.truncate(maxValueLength);
+        text += "…";
+    }
+    return text;
+}
+
+static QString messageToString(const Message &message) {
+    std::string json;
+    google::protobuf::util::MessageToJsonString(message, &json, google::protobuf::util::JsonOptions());
+    // 変換が大きくならないよう、UTF-8で1文字が取りうる最大の長さで先に切る
+    if (json.size() > maxValueLength * 4) {
+        json.resize(maxValueLength * 4);
+    }
+    return truncate(QString::fromStdString(json));
+}
+
+/**
+ * indexが負なら繰り返しでないフィールドを読む
+ */
+static QString valueToString(const Message &message, const FieldDescriptor *field, int index) {
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+        return ProtobufField::toDisplayString(message, field, index, maxValueLength);
+    }
+    const auto reflection = message.GetReflection();
+    return messageToString(index >= 0 ? reflection->GetRepeatedMessage(message, field, index)
+                                      : reflection->GetMessage(message, field));
+}
+
+using SpecificField = MessageDifferencer::SpecificField;
+
+/**
+ * 報告された違いを、パスに沿って木に加える
+ * 親の報告は子の後に届くので (PostTraversalOrder)、子を持つ節には値を入れない
+ */
+class DiffTreeBuilder {
+public:
+    using Node = ResponseDiff::Node;
+
+    explicit DiffTreeBuilder(ResponseDiff &diff) : diff(diff) {}
+
+    inline bool isFull() const { return diff.truncated; }
+
+    /**
+     * message1とmessage2は、fieldPathの最後のフィールドを持つメッセージ
+     */
+    void add(Node::Kind kind, const Message &message1, const Message &message2,
+             const std::vector<SpecificField> &fieldPath) {
+        Node *node = &diff.root;
+        for (size_t i = 0; i < fieldPath.size(); i++) {
+            const auto &specific = fieldPath[i];
+            const bool last = i + 1 == fieldPath.size();
+            const auto field = specific.field;
+            if (field == nullptr) {
+                // 定義に無いフィールドは、中を辿らずに番号だけを出す
+                child(node, nullptr, QString("(%1)").arg(specific.unknown_field_number));
+                return;
+            }
+
+            // mapの値はエントリの節にまとめる
+            const auto previous = i > 0 ? fieldPath[i - 1].field : nullptr;
+            const bool mapValue = previous != nullptr && previous->is_map() &&
+                                  field == previous->message_type()->map_value();
+            if (!mapValue) {
+                node = child(node, field, QString::fromStdString(field->json_name()));
+                if (node != nullptr && field->is_repeated() && (specific.index >= 0 || specific.new_index >= 0 ||
+                                                                specific.map_entry1 || specific.map_entry2)) {
+                    const auto elementKind = last ? kind : Node::Parent;
+                    node = child(node, field, elementLabel(specific, elementKind), elementKind);
+                }
+                if (node == nullptr) {
+                    return;
+                }
+            }
+
+            // 子に違いがあったメッセージは、値ではなく子で見せる
+            // mapのエントリは値の報告で埋まっているので、後から来るエントリ自身の報告は読み飛ばす
+            if (last && node->children.empty() && node->kind == Node::Parent) {
+                node->kind = kind;
+                if (kind != Node::Added) {
+                    node->left = leafValue(message1, field, specific.index, specific.map_entry1);
+                }
+                if (kind != Node::Deleted) {
+                    node->right = leafValue(message2, field, specific.new_index, specific.map_entry2);
+                }
+                diff.differences++;
+            }
+        }
+    }
+
+private:
+    ResponseDiff &diff;
+    int nodes = 0;
+    // 追加と削除の要素は、位置が同じでも別の要素なので分けておく
+    std::map<std::tuple<const Node *, const FieldDescriptor *, QString, Node::Kind>, Node *> children;
+
+    Node *child(Node *parent, const FieldDescriptor *field, const QString &label, Node::Kind kind = Node::Parent) {
+        const auto key = std::make_tuple(parent, field, label, kind == Node::Modified ? Node::Parent : kind);
+        const auto found = children.find(key);
+        if (found != children.end()) {
+            return found->second;
+        }
+        if (nodes >= maxNodes) {
+            diff.truncated = true;
+            return nullptr;
+        }
+        nodes++;
+        parent->children.push_back(std::make_unique<Node>(parent, parent->children.size(), label));
+        return children[key] = parent->children.back().get();
+    }
+
+    /**
+     * 追加された要素では左側の、削除された要素では右側の位置とエントリは使えない
+     */
+    static QString elementLabel(const SpecificField &specific, Node::Kind kind) {
+        const auto entry = kind == Node::Added ? specific.map_entry2 : specific.map_entry1;
+        if (specific.field->is_map() && entry != nullptr) {
+            return QString("[%1]").arg(valueToString(*entry, specific.field->message_type()->map_key(), -1));
+        }
+        if (kind == Node::Added) {
+            return QString("[%1]").arg(specific.new_index);
+        }
+        if (kind != Node::Deleted && specific.new_index >= 0 && specific.index != specific.new_index) {
+            return QString("[%1 → %2]").arg(specific.index).arg(specific.new_index);
+        }
+        return QString("[%1]").arg(specific.index);
+    }
+
+    /**
+     * messageはfieldを直接持つメッセージ。indexはその側での要素の位置
+     */
+    static QString leafValue(const Message &message, const FieldDescriptor *field, int index,
+                             const Message *mapEntry) {
+        if (field->is_map()) {
+            return mapEntry != nullptr ? valueToString(*mapEntry, field->message_type()->map_value(), -1) : QString();
+        }
+        if (field->is_repeated()) {
+            if (index < 0 || index >= message.GetReflection()->FieldSize(message, field)) {
+                return QString();
+            }
+            return valueToString(message, field, index);
+        }
+        return valueToString(message, field, -1);
+    }
+};
+
+/**
+ * 報告されたパスの前に、呼び出し元までのパスを付けて木に加える
+ */
+class PrefixedReporter : public MessageDifferencer::Reporter {
+public:
+    PrefixedReporter(DiffTreeBuilder &builder, const std::vector<SpecificField> &prefix)
+        : builder(builder), prefix(prefix) {}
+
+    void ReportAdded(const Message &message1, const Message &message2,
+                     const std::vector<SpecificField> &fieldPath) override {
+        report(ResponseDiff::Node::Added, message1, message2, fieldPath);
+    }
+
+    void ReportDeleted(const Message &message1, const Message &message2,
+                       const std::vector<SpecificField> &fieldPath) override {
+        report(ResponseDiff::Node::Deleted, message1, message2, fieldPath);
+    }
+
+    void ReportModified(const Message &message1, const Message &message2,
+                        const std::vector<SpecificField> &fieldPath) override {
+        report(ResponseDiff::Node::Modified, message1, message2, fieldPath);
+    }
+
+private:
+    DiffTreeBuilder &builder;
+    const std::vector<SpecificField> &prefix;
+
+    void report(ResponseDiff::Node::Kind kind, const Message &message1, const Message &message2,
+                const std::vector<SpecificField> &fieldPath) {
+        if (prefix.empty()) {
+            builder.add(kind, message1, message2, fieldPath);
+            return;
+        }
+        auto path = prefix;
+        path.insert(path.end(), fieldPath.begin(), fieldPath.end());
+        builder.add(kind, message1, message2, path);
+    }
+};
+
+/**
+ * MessageDifferencerで比べる。ただしキーを指定したrepeatedフィールドは、ここでキーのハッシュを使って突き合わせる
+ * MessageDifferencerのTreatAsMapは要素数の2乗に比例する時間が掛かり、数万件の要素で固まるため
+ */
+class DiffRunner {
+public:
+    DiffRunner(DiffTreeBuilder &builder, const Descriptor *type, const ResponseDiff::Options &options)
+        : builder(builder), floatMargin(options.floatMargin) {
+        for (const auto &spec : options.keys) {
+            const FieldDescriptor *field;
+            FieldPath key;
+            if (resolveKey(type, spec, field, key)) {
+                keys.emplace(field, std::move(key));
+            }
+        }
+        for (const auto &path : options.ignoredPaths) {
+            auto fields = resolvePath(type, path);
+            if (!fields.empty()) {
+                ignoredPaths.push_back(std::move(fields));
+            }
+        }
+    }
+
+    /**
+     * prefixはmessage1とmessage2に至るまでのパス
+     */
+    void compare(const Message &message1, const Message &message2, const std::vector<SpecificField> &prefix) {
+        // differencerより後に破棄する
+        DefaultFieldComparator comparator;
+        comparator.set_treat_nan_as_equal(true);
+        if (floatMargin > 0) {
+            comparator.set_float_comparison(DefaultFieldComparator::APPROXIMATE);
+            comparator.SetDefaultFractionAndMargin(0, floatMargin);
+        }
+        PrefixedReporter reporter(builder, prefix);
+
+        MessageDifferencer differencer;
+        differencer.set_field_comparator(&comparator);
+        // JSONの表示と同じく、値の無いフィールドと既定値は区別しない
+        differencer.set_message_field_comparison(MessageDifferencer::EQUIVALENT);
+        differencer.set_report_moves(false);
+        differencer.AddIgnoreCriteria(new Criteria(*this, prefix));
+        differencer.ReportDifferencesTo(&reporter);
+        differencer.Compare(message1, message2);
+    }
+
+private:
+    /**
+     * 指定されたパスを無視する。キーで突き合わせるフィールドは、ここで比べ終えてから無視させる
+     */
+    class Criteria : public MessageDifferencer::IgnoreCriteria {
+    public:
+        Criteria(DiffRunner &runner, const std::vector<SpecificField> &prefix) : runner(runner), prefix(prefix) {}
+
+        bool IsIgnored(const Message &message1, const Message &message2, const FieldDescriptor *field,
+                       const std::vector<SpecificField> &parentFields) override {
+            if (runner.isIgnoredPath(prefix, parentFields, field)) {
+                return true;
+            }
+            const auto key = runner.keys.find(field);
+            if (key == runner.keys.end()) {
+                return false;
+            }
+            auto path = prefix;
+            path.insert(path.end(), parentFields.begin(), parentFields.end());
+            runner.compareByKey(message1, message2, field, key->second, path);
+            return true;
+        }
+
+    private:
+        DiffRunner &runner;
+        const std::vector<SpecificField> &prefix;
+    };
+
+    DiffTreeBuilder &builder;
+    const double floatMargin;
+    std::map<const FieldDescriptor *, FieldPath> keys;
+    std::vector<FieldPath> ignoredPaths;
+
+    bool isIgnoredPath(const std::vector<SpecificField> &prefix, const std::vector<SpecificField> &parentFields,
+                       const FieldDescriptor *field) const {
+        for (const auto &path : ignoredPaths) {
+            if (path.back() != field || path.size() != prefix.size() + parentFields.size() + 1) {
+                continue;
+            }
+            const auto matches = [](const SpecificField &specific, const FieldDescriptor *f) {
+                return specific.field == f;
+            };
+            if (std::equal(prefix.begin(), prefix.end(), path.begin(), matches) &&
+                std::equal(parentFields.begin(), parentFields.end(), path.begin() + prefix.size(), matches)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static std::string keyOf(const Message &element, const FieldPath &key) {
+        const Message *message = &element;
+        for (size_t i = 0; i + 1 < key.size(); i++) {
+            message = &message->GetReflection()->GetMessage(*message, key[i]);
+        }
+        std::string out;
+        google::protobuf::TextFormat::PrintFieldValueToString(*message, key.back(), -1, &out);
+        return out;
+    }
+
+    /**
+     * 同じキーの要素どうしを比べ、相手の無い要素は削除と追加にする。キーが重複していれば先に出たものから組にする
+     */
+    void compareByKey(const Message &message1, const Message &message2, const FieldDescriptor *field,
+                      const FieldPath &key, std::vector<SpecificField> path) {
+        const auto reflection1 = message1.GetReflection();
+        const auto reflection2 = message2.GetReflection();
+        const int size1 = reflection1->FieldSize(message1, field);
+        const int size2 = reflection2->FieldSize(message2, field);
+
+        // 後ろから積んで、先頭の要素から取り出せるようにする
+        std::unordered_map<std::string, std::vector<int>> indices2;
+        for (int j = size2 - 1; j >= 0; j--) {
+            indices2[keyOf(reflection2->GetRepeatedMessage(message2, field, j), key)].push_back(j);
+        }
+
+        std::vector<bool> matched2(size2, false);
+        path.emplace_back();
+        auto &element = path.back();
+        element.field = field;
+        for (int i = 0; i < size1 && !builder.isFull(); i++) {
+            const auto &element1 = reflection1->GetRepeatedMessage(message1, field, i);
+            element.index = i;
+            const auto found = indices2.find(keyOf(element1, key));
+            if (found == indices2.end() || found->second.empty()) {
+                element.new_index = -1;
+                builder.add(ResponseDiff::Node::Deleted, message1, message2, path);
+                continue;
+            }
+            const int j = found->second.back();
+            found->second.pop_back();
+            matched2[j] = true;
+            element.new_index = j;
+            compare(element1, reflection2->GetRepeatedMessage(message2, field, j), path);
+        }
+        element.index = -1;
+        for (int j = 0; j < size2 && !builder.isFull(); j++) {
+            if (!matched2[j]) {
+                element.new_index = j;
+                builder.add(ResponseDiff::Node::Added, message1, message2, path);
+            }
+        }
+    }
+};
+
+QString ResponseDiff::checkOptions(const Descriptor *type, const Options &options) {
+    std::set<const FieldDescriptor *> keyed;
+    for (const auto &spec : options.keys) {
+        const FieldDescriptor *field;
+        FieldPath key;
+        if (!resolveKey(type, spec, field, key)) {
+            return QString("%1 はキーにできません。メッセージのrepeatedフィールドを \"フィールド=キー\" の形で指定します")
+                .arg(spec.trimmed());
+        }
+        if (!keyed.insert(field).second) {
+            return QString("%1 のキーが複数あります").arg(spec.split('=')[0].trimmed());
+        }
+    }
+    for (const auto &path : options.ignoredPaths) {
+        if (resolvePath(type, path).empty()) {
+            return QString("%1 というフィールドはありません").arg(path.trimmed());
+        }
+    }
+    return QString();
+}
+
+std::shared_ptr<const ResponseDiff> ResponseDiff::compare(const Message &left, const Message &right,
+                                                          const Options &options) {
+    std::shared_ptr<ResponseDiff> diff(new ResponseDiff());
+    DiffTreeBuilder builder(*diff);
+    DiffRunner(builder, left.GetDescriptor(), options).compare(left, right, {});
+    return diff;
+}
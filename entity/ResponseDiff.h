@@ -0,0 +1,79 @@
+#ifndef FLORARPC_RESPONSEDIFF_H
+#define FLORARPC_RESPONSEDIFF_H
+
+#include <google/protobuf/message.h>
+
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+/**
+ * 2つのレスポンスをフィールド単位で比べた結果。違いのあるフィールドと、そこへ至る親だけを木として持つ
+ * 値は文字列にしてあるので、比べたメッセージを手放した後も使える
+ */
+class ResponseDiff {
+public:
+    struct Options {
+        // repeatedフィールドをキーで突き合わせる。"items=id" や "groups.members=user.id" のように書く
+        QStringList keys;
+        // 比べないフィールドのパス。"metadata.updated_at" のように書く
+        QStringList ignoredPaths;
+        // 浮動小数点数の差がこれ以下なら同じとみなす
+        double floatMargin = 0;
+    };
+
+    struct Node {
+        enum Kind {
+            // 子に違いがあるだけのもの
+            Parent,
+            Added,
+            Deleted,
+            Modified,
+        };
+
+        Node *parent;
+        int row;
+        Kind kind = Parent;
+        QString label;
+        QString left;
+        QString right;
+        std::vector<std::unique_ptr<Node>> children;
+
+        Node(Node *parent, int row, QString label) : parent(parent), row(row), label(std::move(label)) {}
+    };
+
+    /**
+     * typeに無いフィールドをoptionsが指していれば、その説明を返す。問題が無ければ空
+     */
+    static QString checkOptions(const google::protobuf::Descriptor *type, const Options &options);
+
+    /**
+     * leftとrightを比べる。optionsのうち解決できないものは無視する
+     */
+    static std::shared_ptr<const ResponseDiff> compare(const google::protobuf::Message &left,
+                                                       const google::protobuf::Message &right, const Options &options);
+
+    inline const Node &getRoot() const { return root; }
+
+    /**
+     * 違いのあったフィールドの数
+     */
+    inline int getDifferenceCount() const { return differences; }
+
+    /**
+     * 違いが多すぎて、途中から木に入れなかった
+     */
+    inline bool isTruncated() const { return truncated; }
+
+private:
+    Node root{nullptr, 0, QString()};
+    int differences = 0;
+    bool truncated = false;
+
+    ResponseDiff() = default;
+
+    friend class DiffTreeBuilder;
+};
+
+#endif  // FLORARPC_RESPONSEDIFF_H
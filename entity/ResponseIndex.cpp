@@ -0,0 +1,235 @@
+#include "ResponseIndex.h"
+
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <algorithm>
+
+#include "util/ProtobufField.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+// 長い文字列は先頭だけを語に分ける
+static constexpr size_t maxIndexedStringLength = 1024;
+// 巨大なメッセージで索引が膨らまないよう、1件から取る語の数を抑える
+static constexpr size_t maxKeysPerMessage = 8192;
+
+static bool isWordChar(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+}
+
+/**
+ * 値を小文字にして語に分ける。記号を含む値は、値全体も1語にする
+ */
+static std::vector<std::string> tokenize(const std::string &value) {
+    auto text = value.substr(0, maxIndexedStringLength);
+    for (auto &c : text) {
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+    }
+
+    std::vector<std::string> words;
+    size_t start = std::string::npos;
+    for (size_t i = 0; i <= text.size(); i++) {
+        if (i < text.size() && isWordChar(text[i])) {
+            if (start == std::string::npos) {
+                start = i;
+            }
+        } else if (start != std::string::npos) {
+            words.push_back(text.substr(start, i - start));
+            start = std::string::npos;
+        }
+    }
+    if (!text.empty() && (words.size() != 1 || words[0].size() != text.size())) {
+        words.push_back(text);
+    }
+    return words;
+}
+
+/**
+ * 索引に入れる値を文字列にする。対象外の型ならfalse
+ */
+static bool valueToString(const Message &message, const FieldDescriptor *field, int index, std::string &out) {
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE || field->type() == FieldDescriptor::TYPE_BYTES) {
+        return false;
+    }
+    out = ProtobufField::formatScalar(message, field, index).text;
+    return true;
+}
+
+static void addValue(const std::string &path, const std::string &value, std::vector<std::string> &keys) {
+    for (const auto &word : tokenize(value)) {
+        if (keys.size() >= maxKeysPerMessage) {
+            return;
+        }
+        keys.push_back(path + ":" + word);
+        keys.push_back(":" + word);
+    }
+}
+
+static void collectKeys(const Message &message, const std::string &prefix, std::vector<std::string> &keys) {
+    const auto reflection = message.GetReflection();
+    std::vector<const FieldDescriptor *> fields;
+    reflection->ListFields(message, &fields);
+
+    std::string value;
+    for (const auto field : fields) {
+        if (keys.size() >= maxKeysPerMessage) {
+            return;
+        }
+
+        const auto path = prefix.empty() ? field->name() : prefix + "." + field->name();
+        if (field->is_map()) {
+            // map<K, V> はキーごとに "path.key" のフィールドとして扱う
+            const auto keyField = field->message_type()->map_key();
+            const auto valueField = field->message_type()->map_value();
+            for (int i = 0; i < reflection->FieldSize(message, field); i++) {
+                const auto &entry = reflection->GetRepeatedMessage(message, field, i);
+                if (!valueToString(entry, keyField, -1, value)) {
+                    continue;
+                }
+                addValue(path, value, keys);
+                const auto entryPath = path + "." + value;
+                if (valueField->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+                    collectKeys(entry.GetReflection()->GetMessage(entry, valueField), entryPath, keys);
+                } else if (valueToString(entry, valueField, -1, value)) {
+                    addValue(entryPath, value, keys);
+                }
+            }
+        } else if (field->is_repeated()) {
+            for (int i = 0; i < reflection->FieldSize(message, field); i++) {
+                if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+                    collectKeys(reflection->GetRepeatedMessage(message, field, i), path, keys);
+                } else if (valueToString(message, field, i, value)) {
+                    addValue(path, value, keys);
+                }
+            }
+        } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+            collectKeys(reflection->GetMessage(message, field), path, keys);
+        } else if (valueToString(message, field, -1, value)) {
+            addValue(path, value, keys);
+        }
+    }
+}
+
+static bool isPathChar(QChar c) { return c.isLetterOrNumber() || c == '_' || c == '.'; }
+
+/**
+ * 検索語のパスを、索引に登録したフィールド名のパスにする。解決できない部分はそのまま残す
+ */
+static std::string resolvePath(const Descriptor *type, const QString &path) {
+    std::string resolved;
+    // mapのフィールドの次はキーなので、フィールドとしては引かない
+    const FieldDescriptor *map = nullptr;
+    const auto parts = path.split('.');
+    for (int i = 0; i < parts.size(); i++) {
+        auto name = parts[i].toStdString();
+        if (map != nullptr) {
+            type = map->message_type()->map_value()->message_type();
+            map = nullptr;
+        } else if (type != nullptr) {
+            const auto field = ProtobufField::findField(type, name);
+            if (field != nullptr) {
+                name = field->name();
+            }
+            map = field != nullptr && field->is_map() ? field : nullptr;
+            type = field != nullptr && map == nullptr ? field->message_type() : nullptr;
+        }
+        if (i > 0) {
+            resolved += '.';
+        }
+        resolved += name;
+    }
+    return resolved;
+}
+
+ResponseIndex::ResponseIndex(const Descriptor *type) : type(type) {}
+
+bool ResponseIndex::add(quint64 epoch, int index, const Message &message) {
+    // 語を集めるのはロックの外で行い、検索を待たせないようにする
+    std::vector<std::string> keys;
+    collectKeys(message, std::string(), keys);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    QWriteLocker locker(&lock);
+    if (epoch != this->epoch) {
+        return false;
+    }
+    for (const auto &key : keys) {
+        auto &list = postings[key];
+        if (list.empty() || list.back() < index) {
+            list.push_back(index);
+        }
+    }
+    return true;
+}
+
+std::vector<int> ResponseIndex::search(const QString &query) const {
+    QReadLocker locker(&lock);
+
+    std::vector<const std::vector<int> *> lists;
+    for (const auto &term : query.simplified().split(' ', Qt::SkipEmptyParts)) {
+        // 先頭がパスとして読める場合だけ、":"までをパスとみなす
+        QString path;
+        QString value = term;
+        const auto colon = term.indexOf(':');
+        if (colon > 0 && std::all_of(term.begin(), term.begin() + colon, isPathChar)) {
+            path = term.left(colon);
+            value = term.mid(colon + 1);
+        }
+
+        const auto prefix = (path.isEmpty() ? std::string() : resolvePath(type, path)) + ":";
+        const auto words = tokenize(value.toStdString());
+        if (words.empty()) {
+            continue;
+        }
+        // 値全体で登録されていればそれを、無ければ各語を全て含むものを探す (最後の要素が値全体)
+        if (const auto exact = find(prefix + words.back())) {
+            lists.push_back(exact);
+            continue;
+        }
+        if (words.size() == 1) {
+            return {};
+        }
+        for (auto word = words.begin(); word != words.end() - 1; word++) {
+            const auto list = find(prefix + *word);
+            if (list == nullptr) {
+                return {};
+            }
+            lists.push_back(list);
+        }
+    }
+    if (lists.empty()) {
+        return {};
+    }
+
+    std::sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+    std::vector<int> result = *lists[0];
+    std::vector<int> intersection;
+    for (size_t i = 1; i < lists.size() && !result.empty(); i++) {
+        intersection.clear();
+        std::set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(intersection));
+        result.swap(intersection);
+    }
+    return result;
+}
+
+quint64 ResponseIndex::clear() {
+    QWriteLocker locker(&lock);
+    postings.clear();
+    return ++epoch;
+}
+
+quint64 ResponseIndex::getEpoch() const {
+    QReadLocker locker(&lock);
+    return epoch;
+}
+
+const std::vector<int> *ResponseIndex::find(const std::string &key) const {
+    const auto found = postings.find(key);
+    return found != postings.end() ? &found->second : nullptr;
+}
@@ -0,0 +1,53 @@
+#ifndef FLORARPC_RESPONSEINDEX_H
+#define FLORARPC_RESPONSEINDEX_H
+
+#include <google/protobuf/message.h>
+
+#include <QReadWriteLock>
+#include <QString>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * レスポンスの文字列、列挙、数値フィールドの値から、語 -> レスポンス番号 の転置索引を作る
+ * 登録はワーカースレッドから、検索はGUIスレッドから同時に行ってよい
+ */
+class ResponseIndex {
+public:
+    /**
+     * typeは登録するメッセージの型。検索語のパスを解決するのに使う
+     */
+    explicit ResponseIndex(const google::protobuf::Descriptor *type);
+
+    /**
+     * messageの値をindex番目のレスポンスとして登録する。indexは昇順に渡す
+     * epochがclearで変わっていた場合は何もせずfalseを返す
+     */
+    bool add(quint64 epoch, int index, const google::protobuf::Message &message);
+
+    /**
+     * 空白で区切った語を全て含むレスポンスの番号を昇順に返す
+     * 語は "user.id:123" のようにフィールドのパスで絞り込める。パスはフィールド名でもjson_nameでも書ける
+     * 大文字と小文字は区別しない
+     */
+    std::vector<int> search(const QString &query) const;
+
+    /**
+     * 全て消して、新しいepochを返す
+     */
+    quint64 clear();
+
+    quint64 getEpoch() const;
+
+private:
+    const google::protobuf::Descriptor *type;
+    mutable QReadWriteLock lock;
+    quint64 epoch = 0;
+    // キーは "パス:語"。パスはフィールド名でつなぐ。パスを問わない検索用に ":語" でも登録する
+    std::unordered_map<std::string, std::vector<int>> postings;
+
+    const std::vector<int> *find(const std::string &key) const;
+};
+
+#endif  // FLORARPC_RESPONSEINDEX_H
@@ -0,0 +1,210 @@
+#include "ResponseLog.h"
+
+#include <QDir>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include <cstring>
+#include <vector>
+
+static const char magic[8] = {'F', 'L', 'R', 'P', 'C', 'L', 'O', 'G'};
+// マジックの後ろにメソッド名の長さ (uint32)
+static constexpr qint64 fileHeaderSize = sizeof(magic) + 4;
+// 受信時刻 (int64) と長さ (uint32)
+static constexpr qint64 recordHeaderSize = 12;
+
+ResponseLog::~ResponseLog() { unmap(); }
+
+bool ResponseLog::create(const QString &path, const QString &methodName) {
+    unmap();
+    offsets.clear();
+    writable = false;
+
+    if (path.isEmpty()) {
+        auto temp =
+            std::make_unique<QTemporaryFile>(QDir::tempPath() + "/florarpc-responses-XXXXXX." + fileExtension);
+        if (!temp->open()) {
+            file.reset();
+            return false;
+        }
+        file = std::move(temp);
+    } else {
+        file = std::make_unique<QFile>(path);
+        if (!file->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+            file.reset();
+            return false;
+        }
+    }
+
+    writable = true;
+    this->methodName = methodName;
+    return writeHeader();
+}
+
+bool ResponseLog::open(const QString &path) {
+    unmap();
+    offsets.clear();
+    writable = false;
+
+    file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        file.reset();
+        return false;
+    }
+    end = file->size();
+
+    char header[fileHeaderSize];
+    if (!readAt(0, header, fileHeaderSize) || std::memcmp(header, magic, sizeof(magic)) != 0) {
+        file.reset();
+        return false;
+    }
+    const qint64 nameLength = qFromLittleEndian<quint32>(header + sizeof(magic));
+    QByteArray name(static_cast<int>(std::min(nameLength, end)), '\0');
+    if (!readAt(fileHeaderSize, name.data(), nameLength)) {
+        file.reset();
+        return false;
+    }
+    methodName = QString::fromUtf8(name);
+
+    // レコードのヘッダーだけを辿って索引を作る
+    qint64 offset = fileHeaderSize + nameLength;
+    char recordHeader[recordHeaderSize];
+    while (readAt(offset, recordHeader, recordHeaderSize)) {
+        const qint64 next = offset + recordHeaderSize + qFromLittleEndian<quint32>(recordHeader + 8);
+        if (next > end) {
+            break;
+        }
+        offsets.append(offset);
+        offset = next;
+    }
+    end = offset;
+    return true;
+}
+
+bool ResponseLog::append(const grpc::ByteBuffer &buffer, qint64 receivedAt) {
+    if (!writable) {
+        offsets.append(-1);
+        return false;
+    }
+
+    std::vector<grpc::Slice> slices;
+    const auto length = buffer.Length();
+    // seekは書き込みバッファを吐き出すので、読み込みで位置が変わった時だけにする
+    if (length > 0xffffffffu || !buffer.Dump(&slices).ok() || (file->pos() != end && !file->seek(end))) {
+        offsets.append(-1);
+        return false;
+    }
+
+    char header[recordHeaderSize];
+    qToLittleEndian<qint64>(receivedAt, header);
+    qToLittleEndian<quint32>(static_cast<quint32>(length), header + 8);
+    bool ok = file->write(header, recordHeaderSize) == recordHeaderSize;
+    for (const auto &slice : slices) {
+        if (!ok) {
+            break;
+        }
+        const auto size = static_cast<qint64>(slice.size());
+        ok = file->write(reinterpret_cast<const char *>(slice.begin()), size) == size;
+    }
+    if (!ok) {
+        // 書きかけの分は次の書き込みで上書きする
+        offsets.append(-1);
+        return false;
+    }
+
+    offsets.append(end);
+    end += recordHeaderSize + static_cast<qint64>(length);
+    return true;
+}
+
+bool ResponseLog::read(int index, grpc::ByteBuffer &buffer, qint64 *receivedAt) {
+    if (index < 0 || index >= offsets.size() || offsets[index] < 0) {
+        return false;
+    }
+
+    const auto offset = offsets[index];
+    char header[recordHeaderSize];
+    if (!readAt(offset, header, recordHeaderSize)) {
+        return false;
+    }
+    const qint64 length = qFromLittleEndian<quint32>(header + 8);
+    grpc::Slice slice(static_cast<size_t>(length));
+    if (!readAt(offset + recordHeaderSize, reinterpret_cast<char *>(const_cast<uint8_t *>(slice.begin())), length)) {
+        return false;
+    }
+
+    if (receivedAt) {
+        *receivedAt = qFromLittleEndian<qint64>(header);
+    }
+    buffer = grpc::ByteBuffer(&slice, 1);
+    return true;
+}
+
+QString ResponseLog::fileName() const { return file ? file->fileName() : QString(); }
+
+std::unique_ptr<ResponseLog> ResponseLog::openReader() {
+    // 書き込みバッファに残っている分は、別に開いたファイルからは見えない
+    if (!file || (writable && !file->flush())) {
+        return nullptr;
+    }
+
+    auto reader = std::make_unique<ResponseLog>();
+    reader->file = std::make_unique<QFile>(file->fileName());
+    if (!reader->file->open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    reader->methodName = methodName;
+    reader->offsets = offsets;
+    reader->end = end;
+    return reader;
+}
+
+bool ResponseLog::writeHeader() {
+    const auto name = methodName.toUtf8();
+    char header[fileHeaderSize];
+    std::memcpy(header, magic, sizeof(magic));
+    qToLittleEndian<quint32>(static_cast<quint32>(name.size()), header + sizeof(magic));
+    if (file->write(header, fileHeaderSize) != fileHeaderSize || file->write(name) != name.size()) {
+        writable = false;
+        return false;
+    }
+    end = fileHeaderSize + name.size();
+    return true;
+}
+
+bool ResponseLog::readAt(qint64 offset, char *dest, qint64 size) {
+    if (offset < 0 || offset + size > end) {
+        return false;
+    }
+    if (ensureMapped(offset + size)) {
+        std::memcpy(dest, mapped + offset, static_cast<size_t>(size));
+        return true;
+    }
+    // マップできない環境 (32bitでの巨大なファイルなど) では普通に読む
+    return file->seek(offset) && file->read(dest, size) == size;
+}
+
+bool ResponseLog::ensureMapped(qint64 size) {
+    if (mapped != nullptr && mappedSize >= size) {
+        return true;
+    }
+
+    // 追記で伸びた分も含めて、ファイル全体をマップし直す
+    unmap();
+    if (writable && !file->flush()) {
+        return false;
+    }
+    mapped = file->map(0, end);
+    if (mapped == nullptr) {
+        return false;
+    }
+    mappedSize = end;
+    return true;
+}
+
+void ResponseLog::unmap() {
+    if (mapped != nullptr) {
+        file->unmap(mapped);
+        mapped = nullptr;
+        mappedSize = 0;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FLORARPC_RESPONSELOG_H
+#define FLORARPC_RESPONSELOG_H
+
+#include <grpcpp/support/byte_buffer.h>
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+/**
+ * レスポンスを追記していくファイル
+ * 先頭にマジックとメソッド名、以降は [受信時刻 int64][長さ uint32][本体] のレコードが並ぶ (リトルエンディアン)
+ * 読み込みはファイルをメモリマップして、索引から直接レコードを引く
+ */
+class ResponseLog {
+public:
+    static constexpr const char *fileExtension = "florarpclog";
+
+    ResponseLog() = default;
+
+    ~ResponseLog();
+
+    ResponseLog(const ResponseLog &) = delete;
+
+    ResponseLog &operator=(const ResponseLog &) = delete;
+
+    /**
+     * 書き込み用に新しいログを作る。pathが空なら、閉じると消える一時ファイルにする
+     */
+    bool create(const QString &path, const QString &methodName);
+
+    /**
+     * 既存のログを読み込み用に開いて、索引を作り直す
+     * 途中で書き込みが止まったログは、最後の完全なレコードまでを読む
+     */
+    bool open(const QString &path);
+
+    /**
+     * 書き込みに失敗したレコードも索引には残り、readがfalseになる
+     */
+    bool append(const grpc::ByteBuffer &buffer, qint64 receivedAt);
+
+    inline int size() const { return offsets.size(); }
+
+    bool read(int index, grpc::ByteBuffer &buffer, qint64 *receivedAt = nullptr);
+
+    inline const QString &getMethodName() const { return methodName; }
+
+    QString fileName() const;
+
+    /**
+     * 同じファイルを読み込み専用で開き直す。今までに追記したレコードだけが見える
+     * 返したものは別のスレッドで使ってよい
+     */
+    std::unique_ptr<ResponseLog> openReader();
+
+private:
+    std::unique_ptr<QFile> file;
+    bool writable = false;
+    QString methodName;
+    // 各レコードの先頭位置。書き込みに失敗したものは-1
+    QVector<qint64> offsets;
+    qint64 end = 0;
+    uchar *mapped = nullptr;
+    qint64 mappedSize = 0;
+
+    bool writeHeader();
+
+    bool readAt(qint64 offset, char *dest, qint64 size);
+
+    bool ensureMapped(qint64 size);
+
+    void unmap();
+};
+
+#endif  // FLORARPC_RESPONSELOG_H
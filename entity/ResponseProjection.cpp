@@ -0,0 +1,244 @@
+#include "ResponseProjection.h"
+
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "util/ByteBufferInputStream.h"
+#include "util/JsonMessagePrinter.h"
+#include "util/ProtobufField.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptor;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::OneofDescriptor;
+using google::protobuf::internal::WireFormatLite;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::StringOutputStream;
+
+// 射影した型を置くパッケージ。元の型と名前がぶつからないようにする
+static const std::string projectionPackage = "florarpc.projection";
+
+static bool isWellKnownType(const Descriptor *type) { return type->file()->package() == "google.protobuf"; }
+
+/**
+ * fileと、その依存を依存の側から順にpoolへ写す
+ */
+static bool copyFile(DescriptorPool &pool, const FileDescriptor *file) {
+    if (pool.FindFileByName(file->name()) != nullptr) {
+        return true;
+    }
+    for (int i = 0; i < file->dependency_count(); i++) {
+        if (!copyFile(pool, file->dependency(i))) {
+            return false;
+        }
+    }
+    FileDescriptorProto proto;
+    file->CopyTo(&proto);
+    file->CopyJsonNameTo(&proto);
+    return pool.BuildFile(proto) != nullptr;
+}
+
+/**
+ * fieldの型 (mapでは値の型) が定義されているファイル
+ */
+static const FileDescriptor *typeFile(const FieldDescriptor *field) {
+    if (field->is_map()) {
+        field = field->message_type()->map_value();
+    }
+    if (const auto message = field->message_type()) {
+        return message->file();
+    }
+    if (const auto enumType = field->enum_type()) {
+        return enumType->file();
+    }
+    return nullptr;
+}
+
+/**
+ * input上のメッセージから、nodeで選ばれたフィールドだけをoutへ書く。inputは次のタグの位置にある
+ */
+static bool filterMessage(CodedInputStream &input, const ResponseProjection::Node &node, std::string &out) {
+    StringOutputStream stream(&out);
+    CodedOutputStream output(&stream);
+    std::string child;
+    while (const auto tag = input.ReadTag()) {
+        const auto field = node.find(WireFormatLite::GetTagFieldNumber(tag));
+        if (field == nullptr) {
+            if (!WireFormatLite::SkipField(&input, tag)) {
+                return false;
+            }
+            continue;
+        }
+        if (!field->child || WireFormatLite::GetTagWireType(tag) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+            // タグごと書き写す
+            if (!WireFormatLite::SkipField(&input, tag, &output)) {
+                return false;
+            }
+            continue;
+        }
+
+        uint32_t length;
+        if (!input.ReadVarint32(&length)) {
+            return false;
+        }
+        const auto limit = input.PushLimit(static_cast<int>(length));
+        child.clear();
+        if (!filterMessage(input, *field->child, child) || !input.ConsumedEntireMessage()) {
+            return false;
+        }
+        input.PopLimit(limit);
+        output.WriteTag(tag);
+        output.WriteVarint32(static_cast<uint32_t>(child.size()));
+        output.WriteString(child);
+    }
+    return !output.HadError();
+}
+
+const ResponseProjection::Node::Field *ResponseProjection::Node::find(int number) const {
+    const auto found = std::lower_bound(fields.begin(), fields.end(), number,
+                                        [](const Field &f, int n) { return f.field->number() < n; });
+    return found != fields.end() && found->field->number() == number ? &*found : nullptr;
+}
+
+std::shared_ptr<const ResponseProjection> ResponseProjection::create(const Descriptor *type, const QStringList &paths,
+                                                                     QString &error) {
+    std::shared_ptr<ResponseProjection> projection(new ResponseProjection(type));
+    for (const auto &path : paths) {
+        auto node = &projection->root;
+        const auto parts = path.trimmed().split('.');
+        for (int i = 0; i < parts.size(); i++) {
+            const auto field = ProtobufField::findField(node->type, parts[i].trimmed().toStdString());
+            if (field == nullptr) {
+                error = QString("%1 というフィールドはありません").arg(path.trimmed());
+                return nullptr;
+            }
+            const bool last = i == parts.size() - 1;
+            // mapとwell-known typeは、JSONでの表現が変わってしまうので中身を選べない
+            if (!last && (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE || field->is_map() ||
+                          isWellKnownType(field->message_type()))) {
+                error = QString("%1 の中のフィールドは選べません").arg(QString::fromStdString(field->name()));
+                return nullptr;
+            }
+
+            auto found = std::lower_bound(node->fields.begin(), node->fields.end(), field->number(),
+                                          [](const Node::Field &f, int n) { return f.field->number() < n; });
+            if (found == node->fields.end() || found->field != field) {
+                found = node->fields.insert(
+                    found, Node::Field{field, last ? nullptr : std::make_unique<Node>(field->message_type())});
+            } else if (last) {
+                // 全体を選んだら、先に選ばれていた一部は要らない
+                found->child.reset();
+            }
+            if (!found->child) {
+                break;
+            }
+            node = found->child.get();
+        }
+    }
+    projection->paths = paths;
+
+    int count = 0;
+    if (!copyFile(projection->pool, type->file()) ||
+        (projection->projectedType = projection->buildProjectedType(projection->root, count)) == nullptr) {
+        error = "選んだフィールドだけの型を作れませんでした";
+        return nullptr;
+    }
+    projection->prototype = projection->factory.GetPrototype(projection->projectedType);
+    projection->printer = std::make_unique<const JsonMessagePrinter>(projection->projectedType);
+    return projection;
+}
+
+ResponseProjection::ResponseProjection(const Descriptor *type) : root(type) {}
+
+ResponseProjection::~ResponseProjection() = default;
+
+bool ResponseProjection::filter(const grpc::ByteBuffer &buffer, std::string &out) const {
+    ByteBufferInputStream stream(buffer);
+    CodedInputStream input(&stream);
+    out.clear();
+    return filterMessage(input, root, out);
+}
+
+google::protobuf::Message *ResponseProjection::parse(const grpc::ByteBuffer &buffer,
+                                                     google::protobuf::Arena &arena) const {
+    std::string projected;
+    filter(buffer, projected);
+    const auto message = prototype->New(&arena);
+    message->ParseFromString(projected);
+    return message;
+}
+
+const Descriptor *ResponseProjection::buildProjectedType(const Node &node, int &count) {
+    const auto type = node.type;
+    const int id = ++count;
+    FileDescriptorProto file;
+    file.set_name(QString("florarpc/projection/%1.proto").arg(id).toStdString());
+    file.set_package(projectionPackage);
+    file.set_syntax(type->file()->syntax() == FileDescriptor::SYNTAX_PROTO3 ? "proto3" : "proto2");
+    const auto message = file.add_message_type();
+    message->set_name(QString("Projected%1").arg(id).toStdString());
+    std::set<std::string> dependencies;
+
+    // 宣言順に並べ直し、oneofは本物を先に、proto3 optionalの合成されたものを後ろに置く
+    std::vector<const Node::Field *> selected;
+    for (int i = 0; i < type->field_count(); i++) {
+        if (const auto field = node.find(type->field(i)->number())) {
+            selected.push_back(field);
+        }
+    }
+    std::map<const OneofDescriptor *, int> oneofs;
+    for (const bool synthetic : {false, true}) {
+        for (const auto field : selected) {
+            const auto oneof = field->field->containing_oneof();
+            if (oneof == nullptr || (field->field->real_containing_oneof() == nullptr) != synthetic ||
+                oneofs.count(oneof) > 0) {
+                continue;
+            }
+            oneofs.emplace(oneof, message->oneof_decl_size());
+            message->add_oneof_decl()->set_name(oneof->name());
+        }
+    }
+
+    for (const auto field : selected) {
+        const auto proto = message->add_field();
+        field->field->CopyTo(proto);
+        proto->set_json_name(field->field->json_name());
+        if (const auto oneof = field->field->containing_oneof()) {
+            proto->set_oneof_index(oneofs[oneof]);
+        }
+
+        if (field->child) {
+            const auto child = buildProjectedType(*field->child, count);
+            if (child == nullptr) {
+                return nullptr;
+            }
+            proto->set_type_name("." + child->full_name());
+            dependencies.insert(child->file()->name());
+            continue;
+        }
+        if (field->field->is_map()) {
+            // mapのエントリーは、それを持つメッセージの中に無ければならない
+            const auto entry = field->field->message_type();
+            entry->CopyTo(message->add_nested_type());
+            proto->set_type_name("." + projectionPackage + "." + message->name() + "." + entry->name());
+        }
+        if (const auto dependency = typeFile(field->field)) {
+            dependencies.insert(dependency->name());
+        }
+    }
+    for (const auto &dependency : dependencies) {
+        file.add_dependency(dependency);
+    }
+
+    const auto built = pool.BuildFile(file);
+    return built != nullptr ? built->message_type(0) : nullptr;
+}
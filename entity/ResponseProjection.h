@@ -0,0 +1,85 @@
+#ifndef FLORARPC_RESPONSEPROJECTION_H
+#define FLORARPC_RESPONSEPROJECTION_H
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/dynamic_message.h>
+#include <grpcpp/support/byte_buffer.h>
+
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <string>
+#include <vector>
+
+class JsonMessagePrinter;
+
+/**
+ * レスポンスのうち、FieldMaskのようにパスで選んだフィールドだけを残す
+ * 選ばれたフィールドだけを持つ型を別のプールに作り、それ以外はワイヤーフォーマットのまま読み飛ばすので、
+ * デコードと表示に掛かる時間は選んだ分の量で決まる
+ */
+class ResponseProjection {
+public:
+    struct Node {
+        struct Field {
+            const google::protobuf::FieldDescriptor *field;
+            // さらに一部だけを残すメッセージ型のフィールド。nullptrならフィールド全体を残す
+            std::unique_ptr<Node> child;
+        };
+
+        // 元のレスポンスの型
+        const google::protobuf::Descriptor *type;
+        // フィールド番号順
+        std::vector<Field> fields;
+
+        explicit Node(const google::protobuf::Descriptor *type) : type(type) {}
+
+        const Field *find(int number) const;
+    };
+
+    /**
+     * pathsは "items.id" のように書く。選べないフィールドを指していればnullptrを返し、errorに説明を入れる
+     */
+    static std::shared_ptr<const ResponseProjection> create(const google::protobuf::Descriptor *type,
+                                                            const QStringList &paths, QString &error);
+
+    ~ResponseProjection();
+
+    /**
+     * bufferから選ばれたフィールドだけを抜き出し、ワイヤーフォーマットのままoutに書く
+     */
+    bool filter(const grpc::ByteBuffer &buffer, std::string &out) const;
+
+    /**
+     * 選ばれたフィールドだけを持つ型でデコードする。返すメッセージはarenaの所有物で、このオブジェクトより先に解放する
+     * 複数のスレッドから同時に呼んでよい
+     */
+    google::protobuf::Message *parse(const grpc::ByteBuffer &buffer, google::protobuf::Arena &arena) const;
+
+    inline const Node &getRoot() const { return root; }
+
+    inline const QStringList &getPaths() const { return paths; }
+
+    /**
+     * parseが返すメッセージの型
+     */
+    inline const google::protobuf::Descriptor *getProjectedType() const { return projectedType; }
+
+    inline const JsonMessagePrinter &getPrinter() const { return *printer; }
+
+private:
+    Node root;
+    QStringList paths;
+    google::protobuf::DescriptorPool pool;
+    google::protobuf::DynamicMessageFactory factory;
+    const google::protobuf::Descriptor *projectedType = nullptr;
+    const google::protobuf::Message *prototype = nullptr;
+    std::unique_ptr<const JsonMessagePrinter> printer;
+
+    explicit ResponseProjection(const google::protobuf::Descriptor *type);
+
+    const google::protobuf::Descriptor *buildProjectedType(const Node &node, int &count);
+};
+
+#endif  // FLORARPC_RESPONSEPROJECTION_H
@@ -0,0 +1,150 @@
+#include "ResponseStore.h"
+
+#include <QDateTime>
+#include <QDir>
+
+ResponseStore::ResponseStore() = default;
+
+void ResponseStore::setBudget(int maxMessages, qint64 maxBytes) {
+    this->maxMessages = maxMessages > 0 ? maxMessages : defaultMaxMessages;
+    this->maxBytes = maxBytes > 0 ? maxBytes : defaultMaxBytes;
+    enforceBudget();
+}
+
+void ResponseStore::setLogDestination(const QString &directory, const QString &methodName) {
+    logDirectory = directory;
+    this->methodName = methodName;
+}
+
+bool ResponseStore::openLog(const QString &path) {
+    clear();
+    auto opened = std::make_unique<ResponseLog>();
+    if (!opened->open(path)) {
+        return false;
+    }
+    log = std::move(opened);
+    totalCount = log->size();
+    return true;
+}
+
+void ResponseStore::append(QVector<grpc::ByteBuffer> &messages, const QVector<qint64> &receivedAt) {
+    if (totalCount == 0 && !log && !logDirectory.isEmpty()) {
+        // 作れなかった場合は、上限を超えた分だけを一時ファイルへ退避する
+        writingThrough = ensureLog(logDirectory) != nullptr;
+    }
+
+    for (int i = 0; i < messages.size(); i++) {
+        auto &message = messages[i];
+        const auto at = i < receivedAt.size() ? receivedAt[i] : QDateTime::currentMSecsSinceEpoch();
+        if (writingThrough) {
+            log->append(message, at);
+        }
+        memoryBytes += static_cast<qint64>(message.Length());
+        memory.push_back({grpc::ByteBuffer(), at});
+        memory.back().buffer.Swap(&message);
+        totalCount++;
+    }
+    messages.clear();
+
+    enforceBudget();
+}
+
+bool ResponseStore::read(int index, grpc::ByteBuffer &buffer, qint64 *receivedAt) {
+    return readEntry(index, totalCount, discardedCount, memory, log.get(), buffer, receivedAt);
+}
+
+QString ResponseStore::logFileName() const { return log ? log->fileName() : QString(); }
+
+QString ResponseStore::logMethodName() const { return log ? log->getMethodName() : QString(); }
+
+std::unique_ptr<ResponseStore::Snapshot> ResponseStore::snapshot() {
+    auto snapshot = std::make_unique<Snapshot>();
+    snapshot->totalCount = totalCount;
+    snapshot->discardedCount = discardedCount;
+    snapshot->memory = memory;
+    if (log) {
+        // 開き直せなければ、ログにしか無いものは破棄済みと同じ扱いになる
+        snapshot->log = log->openReader();
+    }
+    return snapshot;
+}
+
+void ResponseStore::clear() {
+    totalCount = 0;
+    discardedCount = 0;
+    // 一時ファイルは閉じると同時に削除される
+    log.reset();
+    writingThrough = false;
+    memory.clear();
+    memoryBytes = 0;
+}
+
+void ResponseStore::enforceBudget() {
+    while (static_cast<qint64>(memory.size()) > maxMessages || (memoryBytes > maxBytes && memory.size() > 1)) {
+        evictOldest();
+    }
+}
+
+void ResponseStore::evictOldest() {
+    auto &oldest = memory.front();
+    memoryBytes -= static_cast<qint64>(oldest.buffer.Length());
+    if (!writingThrough) {
+        // 一度退避を始めたら、並びを崩さないよう以降も退避する
+        if (overflowPolicy == OverflowPolicy::Spill || log) {
+            if (auto spill = ensureLog(QString())) {
+                spill->append(oldest.buffer, oldest.receivedAt);
+            } else {
+                discardedCount++;
+            }
+        } else {
+            discardedCount++;
+        }
+    }
+    memory.pop_front();
+}
+
+bool ResponseStore::readEntry(int index, int totalCount, int discardedCount, const std::deque<Entry> &memory,
+                              ResponseLog *log, grpc::ByteBuffer &buffer, qint64 *receivedAt) {
+    if (index < 0 || index >= totalCount) {
+        return false;
+    }
+
+    const int memoryStart = totalCount - static_cast<int>(memory.size());
+    if (index >= memoryStart) {
+        const auto &entry = memory[index - memoryStart];
+        // ByteBufferのコピーはスライスの参照を共有するだけ
+        buffer = entry.buffer;
+        if (receivedAt) {
+            *receivedAt = entry.receivedAt;
+        }
+        return true;
+    }
+
+    if (index < discardedCount || !log) {
+        return false;
+    }
+    return log->read(index - discardedCount, buffer, receivedAt);
+}
+
+bool ResponseStore::Snapshot::read(int index, grpc::ByteBuffer &buffer, qint64 *receivedAt) {
+    return readEntry(index, totalCount, discardedCount, memory, log.get(), buffer, receivedAt);
+}
+
+ResponseLog *ResponseStore::ensureLog(const QString &directory) {
+    if (log) {
+        return log.get();
+    }
+
+    QString path;
+    if (!directory.isEmpty()) {
+        const auto timestamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz");
+        const auto name = QString("%1-%2.%3").arg(methodName, timestamp, QLatin1String(ResponseLog::fileExtension));
+        path = QDir(directory).filePath(name);
+    }
+    auto created = std::make_unique<ResponseLog>();
+    if (!created->create(path, methodName)) {
+        return nullptr;
+    }
+    log = std::move(created);
+    return log.get();
+}
@@ -0,0 +1,138 @@
+#ifndef FLORARPC_RESPONSESTORE_H
+#define FLORARPC_RESPONSESTORE_H
+
+#include <grpcpp/support/byte_buffer.h>
+
+#include <QString>
+#include <QVector>
+#include <deque>
+#include <memory>
+
+#include "ResponseLog.h"
+
+/**
+ * 受信したレスポンスを保持する。メモリ上に置くのは新しい方から上限までで、
+ * 上限を超えた古いものはログファイルへ追記するか、破棄する
+ */
+class ResponseStore {
+    struct Entry {
+        grpc::ByteBuffer buffer;
+        qint64 receivedAt;
+    };
+
+public:
+    enum class OverflowPolicy {
+        // 一時ファイルへ退避して、後から読めるようにする
+        Spill,
+        // 古いものから捨てる
+        Discard,
+    };
+
+    /**
+     * ある時点のストアの中身。ストアとは独立しているので、ワーカースレッドで読んでよい
+     */
+    class Snapshot {
+    public:
+        inline int size() const { return totalCount; }
+
+        /**
+         * ResponseStore::readと同じ
+         */
+        bool read(int index, grpc::ByteBuffer &buffer, qint64 *receivedAt = nullptr);
+
+    private:
+        int totalCount = 0;
+        int discardedCount = 0;
+        std::unique_ptr<ResponseLog> log;
+        // ByteBufferのコピーはスライスの参照を共有するだけ
+        std::deque<Entry> memory;
+
+        friend ResponseStore;
+    };
+
+    static constexpr int defaultMaxMessages = 10000;
+    static constexpr qint64 defaultMaxBytes = 256 * 1024 * 1024;
+
+    ResponseStore();
+
+    /**
+     * メモリ上に置く上限。0以下なら既定値を使う
+     * 最新の1件は、maxBytesを超えていてもメモリに置く
+     */
+    void setBudget(int maxMessages, qint64 maxBytes);
+
+    inline void setOverflowPolicy(OverflowPolicy policy) { overflowPolicy = policy; }
+
+    /**
+     * directoryを指定すると、全てのレスポンスを受信した順にそこのログへ書き出し、後から開けるようにする
+     * 空なら、上限を超えた分だけを一時ファイルへ退避する。次のclearの後から有効になる
+     */
+    void setLogDestination(const QString &directory, const QString &methodName);
+
+    /**
+     * 保存済みのログを開いて、その内容だけを持つ状態にする
+     */
+    bool openLog(const QString &path);
+
+    /**
+     * messagesの中身を末尾へ移す。messagesは空になる
+     * receivedAtはそれぞれの受信時刻 (エポックからのミリ秒)
+     */
+    void append(QVector<grpc::ByteBuffer> &messages, const QVector<qint64> &receivedAt);
+
+    /**
+     * 破棄したものも含めた、受信した件数
+     */
+    inline int size() const { return totalCount; }
+
+    inline bool isEmpty() const { return totalCount == 0; }
+
+    /**
+     * index番目のレスポンスを読む。破棄済みか、ログから読めなかった場合はfalse
+     */
+    bool read(int index, grpc::ByteBuffer &buffer, qint64 *receivedAt = nullptr);
+
+    /**
+     * 書き出し中、または開いているログのパス。無ければ空
+     */
+    QString logFileName() const;
+
+    /**
+     * openLogで開いたログを記録したメソッド。無ければ空
+     */
+    QString logMethodName() const;
+
+    /**
+     * 今の中身を、後から追加や破棄をしても変わらない形で取り出す
+     * ログへ退避した分は、ログを開き直して読む
+     */
+    std::unique_ptr<Snapshot> snapshot();
+
+    void clear();
+
+private:
+    int maxMessages = defaultMaxMessages;
+    qint64 maxBytes = defaultMaxBytes;
+    OverflowPolicy overflowPolicy = OverflowPolicy::Spill;
+    QString logDirectory;
+    QString methodName;
+
+    int totalCount = 0;
+    // 並びは 破棄したもの -> ログ -> メモリ の順。ただし書き出し中のログは、メモリにあるものも含む
+    int discardedCount = 0;
+    std::unique_ptr<ResponseLog> log;
+    bool writingThrough = false;
+    std::deque<Entry> memory;
+    qint64 memoryBytes = 0;
+
+    void enforceBudget();
+
+    void evictOldest();
+
+    ResponseLog *ensureLog(const QString &directory);
+
+    static bool readEntry(int index, int totalCount, int discardedCount, const std::deque<Entry> &memory,
+                          ResponseLog *log, grpc::ByteBuffer &buffer, qint64 *receivedAt);
+};
+
+#endif  // FLORARPC_RESPONSESTORE_H
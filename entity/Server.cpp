@@ -23,7 +23,8 @@ void Server::writeServer(florarpc::Server& server) {
     server.set_tls_target_name_override(tlsTargetNameOverride.toStdString());
 }
 
-std::shared_ptr<Certificate> Server::findCertificate(const std::vector<std::shared_ptr<Certificate>>& certificates) {
+std::shared_ptr<Certificate> Server::findCertificate(
+    const std::vector<std::shared_ptr<Certificate>>& certificates) const {
     if (!useTLS || certificateUUID.isNull()) {
         return nullptr;
     }
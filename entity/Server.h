@@ -15,7 +15,7 @@ public:
 
     void writeServer(florarpc::Server &server);
 
-    std::shared_ptr<Certificate> findCertificate(const std::vector<std::shared_ptr<Certificate>> &certificates);
+    std::shared_ptr<Certificate> findCertificate(const std::vector<std::shared_ptr<Certificate>> &certificates) const;
 
     QUuid id;
     QString name;
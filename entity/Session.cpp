@@ -1,10 +1,12 @@
 #include "Session.h"
 
-#include <grpcpp/create_channel.h>
 #include <grpcpp/generic/generic_stub.h>
 
+#include <QDateTime>
 #include <QDebug>
-#include <QRunnable>
+#include <algorithm>
+
+#include "../util/GrpcUtility.h"
 
 class Session::QueueWatcher : public QObject {
     Q_OBJECT
@@ -16,7 +18,9 @@ signals:
 
     void messageSent();
 
-    void messageReceived(const grpc::ByteBuffer &buffer);
+    void messagesAvailable();
+
+    void readPausedChanged(bool paused);
 
     void initialMetadataReceived(const Session::Metadata &metadata);
 
@@ -28,60 +32,52 @@ signals:
 
     void finish();
 
-public slots:
+public:
+    void proceed(Operation operation, bool ok) {
+        switch (operation) {
+            case Operation::Finish:
+                if (ok) {
+                    onSuccessFinish();
+                } else {
+                    // Illegal sequence
+                    qDebug() << "Session Abort!!";
+                    emit aborted();
+                }
+                return;
+            default:
+                break;
+        }
 
-    void doWork() {
-        using std::chrono::system_clock;
+        if (!ok) {
+            emit finish();
+            return;
+        }
 
-        void *gotTag;
-        bool ok;
-        while (auto event = session.queue.AsyncNext(&gotTag, &ok, system_clock::now())) {
-            if (event == grpc::CompletionQueue::SHUTDOWN) {
+        switch (session.sequence) {
+            case Sequence::Preparing:
+                onSuccessStartCall();
                 break;
-            }
-            if (event == grpc::CompletionQueue::TIMEOUT) {
-                if (QThread::currentThread()->isInterruptionRequested()) {
-                    break;
+            case Sequence::Connected:
+                if (operation == Operation::InitialMetadata) {
+                    onSuccessReadInitialMetadata();
+                } else if (operation == Operation::Read) {
+                    onSuccessRead();
+                } else {
+                    onSuccessWrite();
                 }
-                continue;
-            }
-
-            if (!ok) {
-                emit finish();
-                continue;
-            }
-
-            switch (session.sequence) {
-                case Sequence::Preparing:
-                    onSuccessStartCall();
-                    break;
-                case Sequence::Connected:
-                    if (gotTag == session.readTag()) {
-                        onSuccessRead();
-                    } else if (gotTag == session.writeTag()) {
-                        onSuccessWrite();
-                    } else {
-                        qDebug() << "Unknown tag!! : " << gotTag;
-                    }
-                    break;
-                case Sequence::WritesDone:
-                    if (gotTag == session.readTag()) {
-                        onSuccessRead();
-                    } else if (gotTag == session.writeTag()) {
-                        onSuccessWritesDone();
-                    } else {
-                        qDebug() << "Unknown tag!! : " << gotTag;
-                    }
-                    break;
-                case Sequence::Finishing:
-                    onSuccessFinish();
-                    return;
-            }
+                break;
+            case Sequence::WritesDone:
+                if (operation == Operation::InitialMetadata) {
+                    onSuccessReadInitialMetadata();
+                } else if (operation == Operation::Read) {
+                    onSuccessRead();
+                } else {
+                    onSuccessWritesDone();
+                }
+                break;
+            case Sequence::Finishing:
+                break;
         }
-
-        // Illegal sequence
-        qDebug() << "Session Abort!!";
-        emit aborted();
     }
 
 private:
@@ -89,34 +85,67 @@ private:
 
     void onSuccessStartCall() {
         qDebug() << __FUNCTION__;
+        const auto now = std::chrono::steady_clock::now();
+        if (!session.timeline.channelReady) {
+            // The call can't start before the transport is up. The channel state isn't watched, because a watch
+            // can't be cancelled and would keep waking the poller while the host is unreachable
+            session.timeline.channelReady = now;
+        }
+        session.timeline.callStarted = now;
         session.sequence = Sequence::Connected;
-        session.writeTag.advance();
         if (session.method.isClientStreaming()) {
-            session.call->Write(session.writeBuffer, session.writeTag());
+            session.call->Write(session.writeBuffer, session.beginOperation(session.writeTag));
         } else {
-            session.call->WriteLast(session.writeBuffer, grpc::WriteOptions(), session.writeTag());
+            session.call->WriteLast(session.writeBuffer, grpc::WriteOptions(),
+                                    session.beginOperation(session.writeTag));
         }
-        session.call->Read(&session.readBuffer, session.readTag());
+        session.call->ReadInitialMetadata(session.beginOperation(session.initialMetadataTag));
     }
 
-    void onSuccessRead() {
+    void onSuccessReadInitialMetadata() {
         qDebug() << __FUNCTION__;
-        if (!session.receivedInitialMetadata) {
-            session.receivedInitialMetadata = true;
-            Metadata metadata;
-            for (const auto &[key, value] : session.context.GetServerInitialMetadata()) {
-                metadata.insert(QString::fromLatin1(key.data(), key.size()),
-                                QString::fromLatin1(value.data(), value.size()));
-            }
-            emit initialMetadataReceived(metadata);
+        session.timeline.initialMetadataReceived = std::chrono::steady_clock::now();
+        Metadata metadata;
+        for (const auto &[key, value] : session.context.GetServerInitialMetadata()) {
+            metadata.insert(QString::fromLatin1(key.data(), key.size()),
+                            QString::fromLatin1(value.data(), value.size()));
         }
+        emit initialMetadataReceived(metadata);
 
-        grpc::ByteBuffer buffer(session.readBuffer);
-        emit messageReceived(buffer);
+        session.call->Read(&session.readBuffer, session.beginOperation(session.readTag));
+    }
 
-        session.readTag.advance();
-        session.readBuffer.Clear();
-        session.call->Read(&session.readBuffer, session.readTag());
+    void onSuccessRead() {
+        qDebug() << __FUNCTION__;
+        const auto now = std::chrono::steady_clock::now();
+        if (!session.timeline.firstMessageReceived) {
+            session.timeline.firstMessageReceived = now;
+        }
+        session.timeline.lastMessageReceived = now;
+
+        bool notify;
+        bool keepReading;
+        {
+            QMutexLocker locker(&session.deliveryLock);
+            // 受信バッファごと受け渡して、次のReadには空のバッファを使う
+            session.deliveryQueue.append(grpc::ByteBuffer());
+            session.deliveryQueue.last().Swap(&session.readBuffer);
+            session.deliveryTimes.append(QDateTime::currentMSecsSinceEpoch());
+            notify = session.deliveryQueue.size() == 1;
+            keepReading = !session.readPausedByUser &&
+                          session.deliveryQueue.size() < session.highWaterMark;
+            session.readPaused = !keepReading;
+        }
+
+        if (notify) {
+            emit messagesAvailable();
+        }
+        if (keepReading) {
+            session.call->Read(&session.readBuffer, session.beginOperation(session.readTag));
+        } else {
+            // Readを出さずにおけばHTTP/2のフロー制御でサーバー側の送信が止まる
+            emit readPausedChanged(true);
+        }
     }
 
     void onSuccessWrite() {
@@ -130,6 +159,7 @@ private:
     void onSuccessFinish() {
         qDebug() << __FUNCTION__;
         session.endTime = std::chrono::steady_clock::now();
+        session.timeline.finished = session.endTime;
         Metadata metadata;
         for (const auto &[key, value] : session.context.GetServerTrailingMetadata()) {
             metadata.insert(QString::fromLatin1(key.data(), key.size()),
@@ -141,43 +171,66 @@ private:
     }
 };
 
-Session::Session(const Method &method, const QString &serverAddress, std::shared_ptr<grpc::ChannelCredentials> &creds,
-                 const grpc::ChannelArguments &channelArguments, const Metadata &metadata, QObject *parent)
+Session::Session(const Method &method, std::shared_ptr<grpc::Channel> channel, const Metadata &metadata,
+                 QObject *parent)
     : QObject(parent),
       method(method),
+      queue(CallEngine::shared().assignQueue()),
+      channel(std::move(channel)),
+      watcher(std::make_unique<QueueWatcher>(*this)),
       beginTime(std::chrono::steady_clock::now()),
       endTime(beginTime),
-      readTag(true),
-      writeTag(false) {
+      initialMetadataTag(*this, Operation::InitialMetadata),
+      readTag(*this, Operation::Read),
+      writeTag(*this, Operation::Write),
+      finishTag(*this, Operation::Finish) {
     qRegisterMetaType<Metadata>();
     qRegisterMetaType<grpc::ByteBuffer>();
     for (auto iter = metadata.cbegin(); iter != metadata.cend(); iter++) {
         context.AddMetadata(iter.key().toStdString(), iter.value().toStdString());
     }
 
-    channel = grpc::CreateCustomChannel(serverAddress.toStdString(), creds, channelArguments);
-    grpc::GenericStub stub(channel);
-    call = stub.PrepareCall(&context, method.getRequestPath(), &queue);
+    grpc::GenericStub stub(this->channel);
+    call = stub.PrepareCall(&context, method.getRequestPath(), queue);
+
+    timeline.begin = beginTime;
+    if (this->channel->GetState(true) == GRPC_CHANNEL_READY) {
+        // reused connection
+        timeline.channelReady = beginTime;
+    }
 
-    auto watcher = new QueueWatcher(*this);
-    watcher->moveToThread(&queueWatcherWorker);
-    connect(&queueWatcherWorker, &QThread::finished, watcher, &QObject::deleteLater);
-    connect(this, &Session::start, watcher, &QueueWatcher::doWork);
-    connect(watcher, &QueueWatcher::messageSent, this, &Session::messageSent);
-    connect(watcher, &QueueWatcher::messageReceived, this, &Session::messageReceived);
-    connect(watcher, &QueueWatcher::initialMetadataReceived, this, &Session::initialMetadataReceived);
-    connect(watcher, &QueueWatcher::trailingMetadataReceived, this, &Session::trailingMetadataReceived);
-    connect(watcher, &QueueWatcher::finished, this, &Session::finished);
-    connect(watcher, &QueueWatcher::aborted, this, &Session::aborted);
-    connect(watcher, &QueueWatcher::finish, this, &Session::finish);
-    queueWatcherWorker.start();
-    emit start();
+    flushTimer.setSingleShot(true);
+    flushTimer.setTimerType(Qt::PreciseTimer);
+    connect(&flushTimer, &QTimer::timeout, this, &Session::deliverMessages);
+
+    // watcher emits from the engine's poller threads, so these are queued connections
+    connect(watcher.get(), &QueueWatcher::messageSent, this, &Session::messageSent);
+    connect(watcher.get(), &QueueWatcher::messagesAvailable, this, &Session::deliverMessages);
+    connect(watcher.get(), &QueueWatcher::readPausedChanged, this, &Session::readPausedChanged);
+    connect(watcher.get(), &QueueWatcher::initialMetadataReceived, this, &Session::initialMetadataReceived);
+    // 間引き中のメッセージが終了通知より後に届かないよう、先に吐き出しておく
+    connect(watcher.get(), &QueueWatcher::trailingMetadataReceived, this, [this](const Metadata &metadata) {
+        flushMessages();
+        emit trailingMetadataReceived(metadata);
+    });
+    connect(watcher.get(), &QueueWatcher::finished, this,
+            [this](int code, const QString &message, const QByteArray &details) {
+                flushMessages();
+                emit finished(code, message, details);
+            });
+    connect(watcher.get(), &QueueWatcher::aborted, this, &Session::aborted);
+    connect(watcher.get(), &QueueWatcher::finish, this, &Session::finish);
 }
 
 Session::~Session() {
-    queueWatcherWorker.requestInterruption();
-    queueWatcherWorker.quit();
-    queueWatcherWorker.wait();
+    // Pending operations complete with ok=false after cancellation. Wait for them, because the engine still holds
+    // pointers to our tags and buffers until then.
+    closing = true;
+    context.TryCancel();
+    QMutexLocker locker(&pendingLock);
+    while (pendingOperations > 0) {
+        pendingDrained.wait(&pendingLock);
+    }
 }
 
 std::chrono::steady_clock::time_point &Session::getBeginTime() { return beginTime; }
@@ -186,14 +239,26 @@ std::chrono::steady_clock::time_point &Session::getEndTime() { return endTime; }
 
 Session::Sequence Session::getSequence() { return sequence; }
 
+QVector<grpc::ByteBuffer> Session::takeMessages(QVector<qint64> &receivedAt) {
+    QVector<grpc::ByteBuffer> messages;
+    messages.swap(receivedMessages);
+    receivedAt.clear();
+    receivedAt.swap(receivedTimes);
+    return messages;
+}
+
+void Session::setHighWaterMark(int count) {
+    highWaterMark = std::max(count, 1);
+    restartReadIfPaused();
+}
+
 void Session::send(const grpc::ByteBuffer &buffer) {
     qDebug() << __FUNCTION__;
     writeBuffer = buffer;
     if (sequence == Sequence::Preparing) {
-        call->StartCall(writeTag());
+        call->StartCall(beginOperation(writeTag));
     } else {
-        writeTag.advance();
-        call->Write(writeBuffer, writeTag());
+        call->Write(writeBuffer, beginOperation(writeTag));
     }
 }
 
@@ -204,8 +269,7 @@ void Session::done() {
         return;
     }
     sequence = Sequence::WritesDone;
-    writeTag.advance();
-    call->WritesDone(writeTag());
+    call->WritesDone(beginOperation(writeTag));
 }
 
 void Session::finish() {
@@ -215,13 +279,97 @@ void Session::finish() {
         return;
     }
     sequence = Sequence::Finishing;
-    writeTag.advance();
-    call->Finish(&statusBuffer, writeTag());
+    call->Finish(&statusBuffer, beginOperation(finishTag));
 }
 
 void Session::cancel() {
     qDebug() << __FUNCTION__;
     context.TryCancel();
+
+    bool paused;
+    {
+        QMutexLocker locker(&deliveryLock);
+        paused = readPaused;
+    }
+    if (paused) {
+        // 失敗して返ってくるReadが無いので、こちらからFinishする
+        finish();
+    }
+}
+
+void Session::pauseReading() {
+    QMutexLocker locker(&deliveryLock);
+    // 発行済みのReadが完了した時点で止まる
+    readPausedByUser = true;
+}
+
+void Session::resumeReading() {
+    {
+        QMutexLocker locker(&deliveryLock);
+        readPausedByUser = false;
+    }
+    restartReadIfPaused();
+}
+
+void Session::deliverMessages() {
+    // 60fps相当より細かく通知しても描画が追いつかないので、その間に届いた分はまとめる
+    constexpr qint64 frameInterval = 16;
+    if (lastFlush.isValid() && lastFlush.elapsed() < frameInterval) {
+        if (!flushTimer.isActive()) {
+            flushTimer.start(static_cast<int>(frameInterval - lastFlush.elapsed()));
+        }
+        return;
+    }
+
+    flushMessages();
+}
+
+void Session::flushMessages() {
+    flushTimer.stop();
+    lastFlush.start();
+
+    {
+        QMutexLocker locker(&deliveryLock);
+        GrpcUtility::moveAppend(receivedMessages, deliveryQueue);
+        receivedTimes += deliveryTimes;
+        deliveryTimes.clear();
+    }
+    if (!receivedMessages.isEmpty()) {
+        emit messagesReceived();
+    }
+
+    restartReadIfPaused();
+}
+
+void *Session::beginOperation(OperationTag &tag) {
+    QMutexLocker locker(&pendingLock);
+    pendingOperations++;
+    return &tag;
+}
+
+void Session::endOperation() {
+    QMutexLocker locker(&pendingLock);
+    if (--pendingOperations == 0) {
+        pendingDrained.wakeAll();
+    }
+}
+
+void Session::restartReadIfPaused() {
+    {
+        QMutexLocker locker(&deliveryLock);
+        if (!readPaused || readPausedByUser || closing || sequence >= Sequence::Finishing ||
+            deliveryQueue.size() >= highWaterMark) {
+            return;
+        }
+        readPaused = false;
+    }
+    call->Read(&readBuffer, beginOperation(readTag));
+    emit readPausedChanged(false);
+}
+
+void Session::OperationTag::proceed(bool ok) {
+    session.watcher->proceed(operation, ok);
+    session.endOperation();
 }
 
 #include "Session.moc"
@@ -5,13 +5,19 @@
 #include <grpcpp/client_context.h>
 #include <grpcpp/completion_queue.h>
 #include <grpcpp/generic/generic_stub.h>
-#include <grpcpp/security/credentials.h>
 
 #include <QMultiMap>
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QObject>
-#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
 #include <chrono>
+#include <optional>
 
+#include "CallEngine.h"
 #include "Method.h"
 
 class Session : public QObject {
@@ -29,8 +35,24 @@ public:
         Finishing,
     };
 
-    Session(const Method &method, const QString &serverAddress, std::shared_ptr<grpc::ChannelCredentials> &creds,
-            const grpc::ChannelArguments &channelArguments, const Metadata &metadata, QObject *parent = nullptr);
+    /**
+     * 呼び出しの各段階に到達した時刻
+     */
+    struct Timeline {
+        std::chrono::steady_clock::time_point begin;
+        // Channelが接続済みになった (DNS, TCP, TLSの完了)。再利用した接続でなければ、StartCallの完了時刻で代える
+        std::optional<std::chrono::steady_clock::time_point> channelReady;
+        // リクエストヘッダを送信した
+        std::optional<std::chrono::steady_clock::time_point> callStarted;
+        std::optional<std::chrono::steady_clock::time_point> initialMetadataReceived;
+        std::optional<std::chrono::steady_clock::time_point> firstMessageReceived;
+        std::optional<std::chrono::steady_clock::time_point> lastMessageReceived;
+        // トレーラーを受信した
+        std::optional<std::chrono::steady_clock::time_point> finished;
+    };
+
+    Session(const Method &method, std::shared_ptr<grpc::Channel> channel, const Metadata &metadata,
+            QObject *parent = nullptr);
 
     ~Session() override;
 
@@ -40,11 +62,31 @@ public:
 
     Sequence getSequence();
 
+    /**
+     * finishedの受信後に参照すること
+     */
+    inline const Timeline &getTimeline() const { return timeline; }
+
+    /**
+     * messagesReceivedで通知されたメッセージを引き取る
+     * 受信バッファのスライスをそのまま渡すので、呼び出し側でのコピーは不要
+     * receivedAtには、それぞれの受信時刻 (エポックからのミリ秒) が入る
+     */
+    QVector<grpc::ByteBuffer> takeMessages(QVector<qint64> &receivedAt);
+
+    /**
+     * 未消化の受信メッセージがこの件数に達したら、消化されるまで次のReadを発行しない
+     */
+    void setHighWaterMark(int count);
+
 signals:
 
     void messageSent();
 
-    void messageReceived(const grpc::ByteBuffer &buffer);
+    /**
+     * 受信したメッセージを最大1フレームに1回、まとめて通知する
+     */
+    void messagesReceived();
 
     void initialMetadataReceived(const Session::Metadata &metadata);
 
@@ -54,7 +96,10 @@ signals:
 
     void aborted();
 
-    void start();
+    /**
+     * 受信を止めている (バックプレッシャーか、pauseReadingによる) 状態が変化した
+     */
+    void readPausedChanged(bool paused);
 
 public slots:
 
@@ -66,48 +111,83 @@ public slots:
 
     void cancel();
 
+    void pauseReading();
+
+    void resumeReading();
+
+private slots:
+
+    void deliverMessages();
+
+    void flushMessages();
+
 private:
-    class SequentialTag {
-    public:
-        explicit SequentialTag(bool reverse) : reverse(reverse) {}
+    class QueueWatcher;
+
+    enum class Operation {
+        InitialMetadata,
+        Read,
+        Write,
+        Finish,
+    };
 
-        void *operator()() {
-            intptr_t tag = reverse ? -count : count;
-            return (void *)tag;
-        }
+    class OperationTag : public CallEngine::Tag {
+    public:
+        OperationTag(Session &session, Operation operation) : session(session), operation(operation) {}
 
-        void advance() {
-            if (++count >= INT32_MAX) {
-                count = 1;
-            }
-        }
+        void proceed(bool ok) override;
 
     private:
-        int32_t count = 1;
-        bool reverse;
+        Session &session;
+        const Operation operation;
     };
 
-    class QueueWatcher;
-
     const Method &method;
 
     grpc::ClientContext context;
-    grpc::CompletionQueue queue;
+    grpc::CompletionQueue *queue;
     std::shared_ptr<grpc::Channel> channel;
     std::unique_ptr<grpc::GenericClientAsyncReaderWriter> call;
-    QThread queueWatcherWorker;
+    std::unique_ptr<QueueWatcher> watcher;
     std::chrono::steady_clock::time_point beginTime;
     std::chrono::steady_clock::time_point endTime;
+    Timeline timeline;
 
     Sequence sequence = Sequence::Preparing;
-    bool receivedInitialMetadata = false;
-    SequentialTag readTag;
-    SequentialTag writeTag;
+    std::atomic<bool> closing{false};
+    OperationTag initialMetadataTag;
+    OperationTag readTag;
+    OperationTag writeTag;
+    OperationTag finishTag;
     grpc::ByteBuffer readBuffer;
     grpc::ByteBuffer writeBuffer;
     grpc::Status statusBuffer;
 
+    // 受信済みでまだmessagesReceivedを発行していないメッセージ
+    QVector<grpc::ByteBuffer> deliveryQueue;
+    QVector<qint64> deliveryTimes;
+    // 通知済みでまだtakeMessagesされていないメッセージ
+    QVector<grpc::ByteBuffer> receivedMessages;
+    QVector<qint64> receivedTimes;
+    std::atomic<int> highWaterMark{1000};
+    bool readPaused = false;
+    bool readPausedByUser = false;
+    QMutex deliveryLock;
+    QTimer flushTimer;
+    QElapsedTimer lastFlush;
+
+    int pendingOperations = 0;
+    QMutex pendingLock;
+    QWaitCondition pendingDrained;
+
+    void *beginOperation(OperationTag &tag);
+
+    void endOperation();
+
+    void restartReadIfPaused();
+
     friend QueueWatcher;
+    friend OperationTag;
 };
 
 Q_DECLARE_METATYPE(Session::Metadata)
@@ -0,0 +1,212 @@
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/text_format.h>
+#include <google/protobuf/timestamp.pb.h>
+#include <google/protobuf/util/json_util.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "util/JsonMessageParser.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::DynamicMessageFactory;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::Message;
+
+// JsonMessageParserが読めたものは、JsonStringToMessageと同じメッセージになることを確かめる
+// 読めなかったものはMethod::parseRequestと同じく汎用のパーサーで読み直し、全体として結果が変わらないことを確かめる
+
+static const char *const proto3File = R"(
+name: "test/item.proto"
+package: "test"
+syntax: "proto3"
+dependency: "google/protobuf/timestamp.proto"
+dependency: "test/legacy.proto"
+message_type {
+  name: "Item"
+  field { name: "id" number: 1 label: LABEL_OPTIONAL type: TYPE_STRING json_name: "id" }
+  field { name: "item_count" number: 2 label: LABEL_OPTIONAL type: TYPE_INT32 json_name: "itemCount" }
+  field { name: "tags" number: 3 label: LABEL_REPEATED type: TYPE_STRING json_name: "tags" }
+  field { name: "attrs" number: 4 label: LABEL_REPEATED type: TYPE_MESSAGE type_name: ".test.Item.AttrsEntry"
+          json_name: "attrs" }
+  field { name: "color" number: 5 label: LABEL_OPTIONAL type: TYPE_ENUM type_name: ".test.Color" json_name: "color" }
+  field { name: "big" number: 6 label: LABEL_OPTIONAL type: TYPE_UINT64 json_name: "big" }
+  field { name: "data" number: 7 label: LABEL_OPTIONAL type: TYPE_BYTES json_name: "data" }
+  field { name: "child" number: 8 label: LABEL_OPTIONAL type: TYPE_MESSAGE type_name: ".test.Item" json_name: "child" }
+  field { name: "a" number: 9 label: LABEL_OPTIONAL type: TYPE_STRING oneof_index: 0 json_name: "a" }
+  field { name: "b" number: 10 label: LABEL_OPTIONAL type: TYPE_INT32 oneof_index: 0 json_name: "b" }
+  field { name: "at" number: 11 label: LABEL_OPTIONAL type: TYPE_MESSAGE type_name: ".google.protobuf.Timestamp"
+          json_name: "at" }
+  field { name: "legacy" number: 12 label: LABEL_OPTIONAL type: TYPE_MESSAGE type_name: ".test.Legacy"
+          json_name: "legacy" }
+  nested_type {
+    name: "AttrsEntry"
+    field { name: "key" number: 1 label: LABEL_OPTIONAL type: TYPE_STRING json_name: "key" }
+    field { name: "value" number: 2 label: LABEL_OPTIONAL type: TYPE_INT32 json_name: "value" }
+    options { map_entry: true }
+  }
+  oneof_decl { name: "choice" }
+}
+enum_type {
+  name: "Color"
+  value { name: "COLOR_UNSPECIFIED" number: 0 }
+  value { name: "RED" number: 1 }
+}
+)";
+
+static const char *const proto2File = R"(
+name: "test/legacy.proto"
+package: "test"
+syntax: "proto2"
+message_type {
+  name: "Legacy"
+  field { name: "id" number: 1 label: LABEL_REQUIRED type: TYPE_INT32 json_name: "id" }
+  field { name: "x" number: 2 label: LABEL_OPTIONAL type: TYPE_STRING json_name: "x" }
+  field { name: "shade" number: 3 label: LABEL_OPTIONAL type: TYPE_ENUM type_name: ".test.Shade" json_name: "shade" }
+}
+enum_type {
+  name: "Shade"
+  value { name: "LIGHT" number: 1 }
+  value { name: "DARK" number: 2 }
+}
+)";
+
+static bool addFile(DescriptorPool &pool, const char *text) {
+    FileDescriptorProto file;
+    return google::protobuf::TextFormat::ParseFromString(text, &file) && pool.BuildFile(file) != nullptr;
+}
+
+static std::string serialize(const Message &message) {
+    std::string out;
+    google::protobuf::io::StringOutputStream stream(&out);
+    google::protobuf::io::CodedOutputStream output(&stream);
+    output.SetSerializationDeterministic(true);
+    message.SerializeWithCachedSizes(&output);
+    output.Trim();
+    return out;
+}
+
+static std::string nested(int depth) {
+    std::string json;
+    for (int i = 0; i < depth; i++) {
+        json += R"({"child":)";
+    }
+    json += "{}";
+    for (int i = 0; i < depth; i++) {
+        json += "}";
+    }
+    return json;
+}
+
+class Checker {
+public:
+    explicit Checker(DynamicMessageFactory &factory) : factory(factory) {}
+
+    /**
+     * expectFastがtrueならJsonMessageParserで読めること、falseなら汎用のパーサーへ回されることも確かめる
+     */
+    void check(const Descriptor *type, const std::string &json, bool expectFast) {
+        google::protobuf::util::JsonParseOptions options;
+        options.ignore_unknown_fields = true;
+        options.case_insensitive_enum_parsing = true;
+        std::unique_ptr<Message> expected(factory.GetPrototype(type)->New());
+        const bool expectedOk = google::protobuf::util::JsonStringToMessage(json, expected.get(), options).ok();
+
+        JsonMessageParser parser(type);
+        std::unique_ptr<Message> actual(factory.GetPrototype(type)->New());
+        const bool fast = parser.parse(json, *actual);
+        bool actualOk = fast;
+        if (!fast) {
+            actual->Clear();
+            actualOk = google::protobuf::util::JsonStringToMessage(json, actual.get(), options).ok();
+        }
+
+        if (fast != expectFast) {
+            fail(type, json, fast ? "JsonMessageParserで読めてしまった" : "JsonMessageParserで読めなかった");
+        } else if (actualOk != expectedOk) {
+            fail(type, json, expectedOk ? "読めるはずの入力がエラーになった" : "エラーになるはずの入力が読めてしまった");
+        } else if (expectedOk && serialize(*actual) != serialize(*expected)) {
+            fail(type, json, "結果が違う");
+        }
+        checked++;
+    }
+
+    int report() const {
+        std::cout << checked << " checked, " << failures << " failed" << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+private:
+    DynamicMessageFactory &factory;
+    int checked = 0;
+    int failures = 0;
+
+    void fail(const Descriptor *type, const std::string &json, const char *reason) {
+        std::cerr << "FAIL " << type->full_name() << " " << json.substr(0, 80) << ": " << reason << std::endl;
+        failures++;
+    }
+};
+
+int main() {
+    DescriptorPool pool;
+    FileDescriptorProto timestampFile;
+    google::protobuf::Timestamp::descriptor()->file()->CopyTo(&timestampFile);
+    if (pool.BuildFile(timestampFile) == nullptr || !addFile(pool, proto2File) || !addFile(pool, proto3File)) {
+        std::cerr << "テスト用の型を作れませんでした" << std::endl;
+        return 1;
+    }
+    const auto item = pool.FindMessageTypeByName("test.Item");
+    const auto legacy = pool.FindMessageTypeByName("test.Legacy");
+
+    DynamicMessageFactory factory(&pool);
+    Checker checker(factory);
+
+    // JsonMessageParserで読めるもの
+    checker.check(item, R"({"id": "x", "itemCount": 3, "tags": ["a", "b"]})", true);
+    checker.check(item, R"({"item_count": 3})", true);
+    checker.check(item, R"({"attrs": {"k": 1, "l": -2}, "color": "RED", "big": "123", "data": "AQID"})", true);
+    checker.check(item, R"({"color": "red"})", true);
+    checker.check(item, R"({"color": 1})", true);
+    checker.check(item, R"({"child": {"id": "n", "child": {}}, "a": "s"})", true);
+    checker.check(item, R"({"unknown": {"x": [1, 2, null]}, "id": "y"})", true);
+    checker.check(item, R"({"unknown": 1e300, "id": "y"})", true);
+    checker.check(item, R"({"id": null, "itemCount": null})", true);
+    checker.check(item, nested(10), true);
+
+    // proto2の型は汎用のパーサーに任せる。requiredが欠けていればエラーになる
+    checker.check(legacy, R"({"x": "a"})", false);
+    checker.check(legacy, R"({"id": 1, "x": "a"})", false);
+    checker.check(legacy, R"({"id": 1, "shade": 7})", false);
+    checker.check(item, R"({"legacy": {"x": "a"}})", false);
+    checker.check(item, R"({"legacy": {"id": 1}})", false);
+
+    // well-known type
+    checker.check(item, R"({"at": "2020-01-01T00:00:00Z"})", false);
+    checker.check(item, R"({"at": null})", false);
+
+    // 汎用のパーサーとの解釈を揃えられないもの
+    checker.check(item, R"({"id": "a", "id": "b"})", false);
+    checker.check(item, R"({"a": "s", "b": 1})", false);
+    checker.check(item, R"({"color": 7})", false);
+    checker.check(item, R"({"color": "PURPLE"})", false);
+    checker.check(item, R"({"big": "-0"})", false);
+    checker.check(item, R"({"data": "AQJ"})", false);
+    checker.check(item, R"({"[test.ext]": 1})", false);
+    checker.check(item, R"({"tags": null})", false);
+    checker.check(item, R"({"a": null})", false);
+    checker.check(item, nested(80), false);
+
+    // 不正なJSON
+    checker.check(item, R"({"id": )", false);
+    checker.check(item, R"({"itemCount": "x"})", false);
+    checker.check(item, R"([])", false);
+    checker.check(item, R"({"unknown": 1e999})", false);
+    checker.check(item, R"({"unknown": [-1e400]})", false);
+
+    return checker.report();
+}
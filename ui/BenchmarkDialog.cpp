@@ -0,0 +1,141 @@
+#include "BenchmarkDialog.h"
+
+#include <QFontDatabase>
+#include <algorithm>
+
+#include "util/GrpcUtility.h"
+
+static QString formatLatency(int64_t micros) { return QString::number(micros / 1000.0, 'f', 3); }
+
+BenchmarkDialog::BenchmarkDialog(const Method &method, std::shared_ptr<grpc::Channel> channel,
+                                 const Session::Metadata &metadata, const grpc::ByteBuffer &request, QWidget *parent)
+    : QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint),
+      resultUpdateTimer(this),
+      method(method),
+      channel(std::move(channel)),
+      metadata(metadata),
+      request(request) {
+    ui.setupUi(this);
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle(QString("ベンチマーク - %1").arg(QString::fromStdString(method.getFullName())));
+
+    connect(ui.modeBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &BenchmarkDialog::onModeChanged);
+    connect(ui.limitModeBox, qOverload<int>(&QComboBox::currentIndexChanged), this,
+            &BenchmarkDialog::updateControls);
+    connect(ui.rampCheck, &QCheckBox::toggled, this, &BenchmarkDialog::updateControls);
+    connect(ui.startButton, &QPushButton::clicked, this, &BenchmarkDialog::onStartButtonClicked);
+    connect(ui.stopButton, &QPushButton::clicked, this, &BenchmarkDialog::onStopButtonClicked);
+    connect(&resultUpdateTimer, &QTimer::timeout, this, &BenchmarkDialog::updateResult);
+
+    ui.resultEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+}
+
+void BenchmarkDialog::onModeChanged(int index) {
+    if (index == 0) {
+        ui.concurrencyLabel->setText("並列数");
+        ui.concurrencySpin->setValue(10);
+    } else {
+        ui.concurrencyLabel->setText("最大同時実行数");
+        ui.concurrencySpin->setValue(100);
+    }
+    updateControls();
+}
+
+void BenchmarkDialog::onStartButtonClicked() {
+    Benchmark::Options options;
+    options.concurrency = ui.concurrencySpin->value();
+    if (ui.limitModeBox->currentIndex() == 0) {
+        options.requests = ui.requestsSpin->value();
+    } else {
+        options.duration = std::chrono::seconds(ui.durationSpin->value());
+    }
+    if (ui.modeBox->currentIndex() == 1) {
+        options.mode = Benchmark::Mode::OpenLoop;
+        options.rate = ui.rateSpin->value();
+        if (ui.rampCheck->isChecked() && options.duration.count() > 0) {
+            options.rampRate = ui.rampRateSpin->value();
+        }
+    }
+
+    benchmark = std::make_unique<Benchmark>(method, channel, metadata, request, options);
+    connect(benchmark.get(), &Benchmark::finished, this, &BenchmarkDialog::onBenchmarkFinished);
+    benchmark->start();
+
+    resultUpdateTimer.start(std::chrono::milliseconds(500));
+    updateControls();
+}
+
+void BenchmarkDialog::onStopButtonClicked() {
+    if (benchmark) {
+        benchmark->stop();
+    }
+}
+
+void BenchmarkDialog::onBenchmarkFinished() {
+    resultUpdateTimer.stop();
+    updateResult();
+    updateControls();
+}
+
+void BenchmarkDialog::updateResult() {
+    if (!benchmark) {
+        return;
+    }
+
+    const auto &histogram = benchmark->getHistogram();
+    const auto count = histogram.getTotalCount();
+    const auto elapsed = std::chrono::duration<double>(benchmark->getElapsed()).count();
+
+    QString result;
+    result += QString("Requests:   %1\n").arg(count);
+    result += QString("Elapsed:    %1 s\n").arg(elapsed, 0, 'f', 3);
+    result += QString("Throughput: %1 req/s\n").arg(elapsed > 0 ? count / elapsed : 0, 0, 'f', 1);
+    if (benchmark->getOptions().mode == Benchmark::Mode::OpenLoop) {
+        // 呼び出しが全て処理中なら、予定した時刻を過ぎても送信されずに待つ。実際に送信できた分だけを達成レートとする
+        const auto started = benchmark->getStartedCount();
+        const auto scheduled = benchmark->getIssuedCount();
+        result += QString("Target:     %1 req/s\n").arg(benchmark->getTargetRate(), 0, 'f', 1);
+        result += QString("Achieved:   %1 req/s\n").arg(elapsed > 0 ? started / elapsed : 0, 0, 'f', 1);
+        result += QString("Scheduled:  %1 (%2 sent, %3 in flight, %4 waiting)\n")
+                      .arg(scheduled)
+                      .arg(started)
+                      .arg(started - count)
+                      .arg(std::max<int64_t>(scheduled - started, 0));
+        result += "\nLatency from intended send time (ms)\n";
+    } else {
+        result += "\nLatency (ms)\n";
+    }
+    result += QString("  min    %1\n").arg(formatLatency(histogram.getMin()));
+    result += QString("  mean   %1\n").arg(histogram.getMean() / 1000.0, 0, 'f', 3);
+    result += QString("  p50    %1\n").arg(formatLatency(histogram.getValueAtPercentile(50)));
+    result += QString("  p90    %1\n").arg(formatLatency(histogram.getValueAtPercentile(90)));
+    result += QString("  p99    %1\n").arg(formatLatency(histogram.getValueAtPercentile(99)));
+    result += QString("  p99.9  %1\n").arg(formatLatency(histogram.getValueAtPercentile(99.9)));
+    result += QString("  max    %1\n").arg(formatLatency(histogram.getMax()));
+    result += "\nStatus\n";
+    for (int code = grpc::StatusCode::OK; code <= grpc::StatusCode::UNAUTHENTICATED; code++) {
+        const auto statusCount = benchmark->getStatusCount(static_cast<grpc::StatusCode>(code));
+        if (statusCount > 0) {
+            result += QString("  %1: %2\n")
+                          .arg(GrpcUtility::errorCodeToString(static_cast<grpc::StatusCode>(code)))
+                          .arg(statusCount);
+        }
+    }
+    ui.resultEdit->setPlainText(result);
+}
+
+void BenchmarkDialog::updateControls() {
+    const auto running = benchmark && benchmark->isRunning();
+    const auto openLoop = ui.modeBox->currentIndex() == 1;
+    const auto durationLimited = ui.limitModeBox->currentIndex() == 1;
+    ui.startButton->setDisabled(running);
+    ui.stopButton->setEnabled(running);
+    ui.modeBox->setDisabled(running);
+    ui.limitModeBox->setDisabled(running);
+    ui.requestsSpin->setEnabled(!running && !durationLimited);
+    ui.durationSpin->setEnabled(!running && durationLimited);
+    ui.concurrencySpin->setDisabled(running);
+    ui.rateSpin->setEnabled(!running && openLoop);
+    ui.rampCheck->setEnabled(!running && openLoop && durationLimited);
+    ui.rampRateSpin->setEnabled(!running && openLoop && durationLimited && ui.rampCheck->isChecked());
+}
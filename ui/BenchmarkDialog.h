@@ -0,0 +1,44 @@
+#ifndef FLORARPC_BENCHMARKDIALOG_H
+#define FLORARPC_BENCHMARKDIALOG_H
+
+#include <QDialog>
+#include <QTimer>
+
+#include "entity/Benchmark.h"
+#include "entity/Method.h"
+#include "entity/Session.h"
+#include "ui/ui_BenchmarkDialog.h"
+
+class BenchmarkDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    BenchmarkDialog(const Method &method, std::shared_ptr<grpc::Channel> channel, const Session::Metadata &metadata,
+                    const grpc::ByteBuffer &request, QWidget *parent = nullptr);
+
+private slots:
+
+    void onModeChanged(int index);
+
+    void onStartButtonClicked();
+
+    void onStopButtonClicked();
+
+    void onBenchmarkFinished();
+
+    void updateResult();
+
+    void updateControls();
+
+private:
+    Ui::BenchmarkDialog ui;
+    QTimer resultUpdateTimer;
+
+    const Method &method;
+    std::shared_ptr<grpc::Channel> channel;
+    Session::Metadata metadata;
+    grpc::ByteBuffer request;
+    std::unique_ptr<Benchmark> benchmark;
+};
+
+#endif  // FLORARPC_BENCHMARKDIALOG_H
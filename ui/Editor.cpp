@@ -1,66 +1,67 @@
 #include "Editor.h"
 
 #include <google/protobuf/text_format.h>
-#include <google/protobuf/util/json_util.h>
 #include <grpcpp/generic/generic_stub.h>
 #include <grpcpp/grpcpp.h>
 
 #include <QClipboard>
+#include <QDateTime>
 #include <QDebug>
+#include <QFileDialog>
+#include <QInputDialog>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMenu>
 #include <QMessageBox>
 #include <QShortcut>
+#include <QToolButton>
+#include <algorithm>
 
+#include "../entity/ChannelPool.h"
 #include "../entity/Metadata.h"
 #include "../entity/Method.h"
+#include "../entity/Preferences.h"
 #include "../util/GrpcUtility.h"
+#include "BenchmarkDialog.h"
+#include "ResponseDiffDialog.h"
 #include "event/WorkspaceModifiedEvent.h"
 #include "google/rpc/status.pb.h"
+#include "task/ExportResponsesTask.h"
 #include "util/SyntaxHighlighter.h"
 
-static std::shared_ptr<grpc::ChannelCredentials> getCredentials(
-    Server &server, std::vector<std::shared_ptr<Certificate>> &certificates) {
-    if (server.useTLS) {
-        auto certificate = server.findCertificate(certificates);
-        if (certificate) {
-            qDebug() << "Using ssl channel credentials with user options";
-            return certificate->getCredentials();
-        } else {
-            qDebug() << "Using default ssl channel credentials";
-            return grpc::SslCredentials(grpc::SslCredentialsOptions());
-        }
-    } else {
-        qDebug() << "Using insecure channel credentials";
-        return grpc::InsecureChannelCredentials();
-    }
-}
-
-static grpc::ChannelArguments getChannelArguments(Server &server) {
-    grpc::ChannelArguments args;
-    if (server.useTLS && !server.tlsTargetNameOverride.isEmpty()) {
-        args.SetSslTargetNameOverride(server.tlsTargetNameOverride.toStdString());
-    }
-    return args;
-}
-
 Editor::Editor(std::unique_ptr<Method> &&method, QWidget *parent)
     : QWidget(parent),
       responseMetadataContextMenu(new QMenu(this)),
       session(nullptr),
       sendingRequest(false),
-      method(std::move(method)) {
+      method(std::move(method)),
+      responseListModel(new ResponseListModel(responses, *this->method, this)),
+      responseTreeModel(new ResponseTreeModel(this)),
+      responseRenderer(new Task::RenderResponseTask(this->method, this)),
+      responseIndexer(new Task::IndexResponsesTask(this->method, this)) {
     ui.setupUi(this);
 
     connect(ui.sendButton, &QPushButton::clicked, this, &Editor::onSendButtonClicked);
     connect(ui.finishButton, &QPushButton::clicked, this, &Editor::onFinishButtonClicked);
     connect(ui.cancelButton, &QPushButton::clicked, this, &Editor::onCancelButtonClicked);
-    connect(ui.responseBodyPageSpin, QOverload<int>::of(&QSpinBox::valueChanged), this,
-            &Editor::onResponseBodyPageChanged);
-    connect(ui.prevResponseBodyButton, &QPushButton::clicked, this, &Editor::onPrevResponseBodyButtonClicked);
-    connect(ui.nextResponseBodyButton, &QPushButton::clicked, this, &Editor::onNextResponseBodyButtonClicked);
-    connect(ui.lastResponseBodyButton, &QPushButton::clicked, this, &Editor::onLastResponseBodyButtonClicked);
+    connect(ui.reconnectButton, &QPushButton::clicked, this, &Editor::onReconnectButtonClicked);
+    connect(ui.benchmarkButton, &QPushButton::clicked, this, &Editor::onBenchmarkButtonClicked);
+    ui.responseListView->setModel(responseListModel);
+    connect(ui.responseListView->selectionModel(), &QItemSelectionModel::currentChanged, this,
+            &Editor::onResponseListCurrentChanged);
+    ui.responseTreeView->setModel(responseTreeModel);
+    ui.responseListView->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui.responseListView, &QWidget::customContextMenuRequested, this,
+            &Editor::onResponseListContextMenuRequested);
+    connect(responseRenderer, &Task::RenderResponseTask::rendered, this, &Editor::onResponseRendered);
+    connect(ui.pauseReadingButton, &QPushButton::toggled, this, &Editor::onPauseReadingButtonToggled);
+    connect(ui.openResponseLogButton, &QPushButton::clicked, this, &Editor::onOpenResponseLogButtonClicked);
+    connect(ui.exportResponsesButton, &QPushButton::clicked, this, &Editor::onExportResponsesButtonClicked);
+    connect(ui.responseSearchEdit, &QLineEdit::returnPressed, this, &Editor::onResponseSearchReturnPressed);
+    connect(ui.responseProjectionEdit, &QLineEdit::editingFinished, this,
+            &Editor::onResponseProjectionEditingFinished);
+    connect(ui.streamBufferSpin, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            &Editor::onStreamBufferSpinChanged);
     connect(ui.serverSelectBox, qOverload<int>(&QComboBox::currentIndexChanged), this,
             &Editor::willEmitWorkspaceModified);
     connect(ui.requestEdit, &QTextEdit::textChanged, this, &Editor::willEmitWorkspaceModified);
@@ -78,8 +79,8 @@ Editor::Editor(std::unique_ptr<Method> &&method, QWidget *parent)
     ui.responseEdit->setFont(fixedFont);
     ui.errorDetailsEdit->setFont(fixedFont);
 
-    requestHighlighter = SyntaxHighlighter::setup(*ui.requestEdit, palette());
-    responseHighlighter = SyntaxHighlighter::setup(*ui.responseEdit, palette());
+    requestHighlighter = SyntaxHighlighter::setupIncremental(*ui.requestEdit, palette());
+    responseHighlighter = SyntaxHighlighter::setupIncremental(*ui.responseEdit, palette());
 
     if (!this->method->isClientStreaming()) {
         ui.requestTabs->removeTab(ui.requestTabs->indexOf(ui.requestHistoryTab));
@@ -108,16 +109,41 @@ Editor::Editor(std::unique_ptr<Method> &&method, QWidget *parent)
                     })
         ->setIcon(QIcon::fromTheme("edit-copy"));
 
+    const auto diffButton = new QToolButton(ui.responseViewTabs);
+    const auto diffMenu = new QMenu(diffButton);
+    diffMenu->addAction("このレスポンスを比較の基準にする(&B)", [=]() {
+        grpc::ByteBuffer buffer;
+        QString label;
+        if (!readResponse(ui.responseListView->currentIndex().row(), buffer, label)) {
+            return;
+        }
+        diffBaseline = buffer;
+        diffBaselineLabel = label;
+    });
+    const auto compareWithBaselineAction = diffMenu->addAction("基準と比較(&C)", [=]() {
+        grpc::ByteBuffer buffer;
+        QString label;
+        if (!diffBaseline || !readResponse(ui.responseListView->currentIndex().row(), buffer, label)) {
+            return;
+        }
+        (new ResponseDiffDialog(method, *diffBaseline, diffBaselineLabel, buffer, label, this))->show();
+    });
+    connect(diffMenu, &QMenu::aboutToShow,
+            [=]() { compareWithBaselineAction->setEnabled(diffBaseline.has_value()); });
+    diffButton->setText("比較");
+    diffButton->setAutoRaise(true);
+    diffButton->setPopupMode(QToolButton::InstantPopup);
+    diffButton->setMenu(diffMenu);
+    ui.responseViewTabs->setCornerWidget(diffButton, Qt::BottomRightCorner);
+
     ui.requestEdit->setText(QString::fromStdString(this->method->makeRequestSkeleton()));
-    if (requestHighlighter) {
-        requestHighlighter->rehighlight();
-    }
 
     if (this->method->isServerStreaming()) {
         ui.responseBodyPagerWrapper->show();
-        ui.responseBodyPager->setDisabled(true);
+        ui.responseListView->show();
     } else {
         ui.responseBodyPagerWrapper->hide();
+        ui.responseListView->hide();
     }
 
     updateSendButton();
@@ -166,6 +192,18 @@ void Editor::readRequest(const florarpc::Request &request) {
         }
     }
     ui.useSharedMetadata->setChecked(request.use_shared_metadata());
+
+    QStringList projectionPaths;
+    for (const auto &path : request.response_projection()) {
+        projectionPaths.append(QString::fromStdString(path));
+    }
+    QString error;
+    // 保存後に型が変わって解決できなくなったものは、黙って外す
+    responseProjection =
+        projectionPaths.isEmpty() ? nullptr
+                                  : ResponseProjection::create(method->getResponseType(), projectionPaths, error);
+    responseListModel->setProjection(responseProjection);
+    ui.responseProjectionEdit->setText(responseProjection ? responseProjection->getPaths().join(", ") : QString());
 }
 
 void Editor::writeRequest(florarpc::Request &request) {
@@ -180,6 +218,12 @@ void Editor::writeRequest(florarpc::Request &request) {
         request.clear_selected_server_id();
     }
     request.set_use_shared_metadata(ui.useSharedMetadata->isChecked());
+    request.clear_response_projection();
+    if (responseProjection) {
+        for (const auto &path : responseProjection->getPaths()) {
+            request.add_response_projection(path.toStdString());
+        }
+    }
 }
 
 QString Editor::getRequestBody() { return ui.requestEdit->toPlainText(); }
@@ -208,17 +252,22 @@ void Editor::onSendButtonClicked() {
     if (initialize) {
         clearResponseView();
         responses.clear();
+        sharedPref().read([this](const florarpc::Preferences &prefs) {
+            responses.setBudget(prefs.response_memory_max_messages(), prefs.response_memory_max_bytes());
+            responses.setOverflowPolicy(prefs.discard_overflowed_responses() ? ResponseStore::OverflowPolicy::Discard
+                                                                             : ResponseStore::OverflowPolicy::Spill);
+            responses.setLogDestination(QString::fromStdString(prefs.response_log_directory()),
+                                        QString::fromStdString(method->getFullName()));
+        });
+        responseListModel->reset();
         ui.requestHistoryTab->clear();
-        ui.responseBodyPageSpin->setValue(1);
-        updateResponsePager();
-        ui.responseBodyPager->setDisabled(true);
     }
 
     // Parse request body
-    google::protobuf::DynamicMessageFactory dmf;
-    std::unique_ptr<google::protobuf::Message> reqMessage;
+    google::protobuf::Arena arena;
+    google::protobuf::Message *reqMessage;
     try {
-        reqMessage = method->parseRequest(dmf, ui.requestEdit->toPlainText().toStdString());
+        reqMessage = method->parseRequest(ui.requestEdit->toPlainText().toStdString(), arena);
     } catch (Method::ParseError &e) {
         if (initialize) {
             setErrorToResponseView("-", "Request Parse Error", QString::fromStdString(e.getMessage()));
@@ -247,15 +296,19 @@ void Editor::onSendButtonClicked() {
         }
 
         auto server = getCurrentServer();
-        auto credentials = getCredentials(*server, certificates);
-        auto channelArgs = getChannelArguments(*server);
-        session = new Session(*method, server->address, credentials, channelArgs, meta.getValues(), this);
+        auto channel = ChannelPool::shared().acquire(*server, certificates);
+        session = new Session(*method, channel, meta.getValues(), this);
         connect(session, &Session::messageSent, this, &Editor::onMessageSent);
-        connect(session, &Session::messageReceived, this, &Editor::onMessageReceived);
+        connect(session, &Session::messagesReceived, this, &Editor::onMessagesReceived);
         connect(session, &Session::initialMetadataReceived, this, &Editor::onMetadataReceived);
         connect(session, &Session::trailingMetadataReceived, this, &Editor::onMetadataReceived);
         connect(session, &Session::finished, this, &Editor::onSessionFinished);
         connect(session, &Session::aborted, this, &Editor::cleanupSession);
+        connect(session, &Session::readPausedChanged, this, &Editor::onReadPausedChanged);
+        session->setHighWaterMark(ui.streamBufferSpin->value());
+        if (ui.pauseReadingButton->isChecked()) {
+            session->pauseReading();
+        }
     }
 
     emit session->send(*sendBuffer);
@@ -294,40 +347,233 @@ void Editor::onCancelButtonClicked() {
     ui.cancelButton->setDisabled(true);
 }
 
-void Editor::onResponseBodyPageChanged(int page) {
-    if (responses.isEmpty() || page < 1 || page > responses.size()) {
-        ui.responseEdit->clear();
+void Editor::onPauseReadingButtonToggled(bool checked) {
+    if (session == nullptr) {
         return;
     }
 
-    google::protobuf::DynamicMessageFactory dmf;
-    auto resMessage = method->parseResponse(dmf, responses[page - 1]);
-    std::string out;
-    google::protobuf::util::JsonOptions opts;
-    opts.add_whitespace = true;
-    opts.always_print_primitive_fields = true;
-    google::protobuf::util::MessageToJsonString(*resMessage, &out, opts);
-    ui.responseEdit->setText(QString::fromStdString(out));
-    if (responseHighlighter) {
-        responseHighlighter->rehighlight();
+    if (checked) {
+        session->pauseReading();
+    } else {
+        session->resumeReading();
     }
+}
 
-    updateResponsePager();
+void Editor::onStreamBufferSpinChanged(int value) {
+    if (session != nullptr) {
+        session->setHighWaterMark(value);
+    }
 }
 
-void Editor::onPrevResponseBodyButtonClicked() {
-    ui.responseBodyPageSpin->setValue(ui.responseBodyPageSpin->value() - 1);
-    updateResponsePager();
+void Editor::onReconnectButtonClicked() {
+    if (auto server = getCurrentServer()) {
+        ChannelPool::shared().reconnect(*server, certificates);
+    }
 }
 
-void Editor::onNextResponseBodyButtonClicked() {
-    ui.responseBodyPageSpin->setValue(ui.responseBodyPageSpin->value() + 1);
-    updateResponsePager();
+void Editor::onBenchmarkButtonClicked() {
+    auto server = getCurrentServer();
+    if (!server) {
+        return;
+    }
+
+    // Parse request body
+    google::protobuf::Arena arena;
+    google::protobuf::Message *reqMessage;
+    try {
+        reqMessage = method->parseRequest(ui.requestEdit->toPlainText().toStdString(), arena);
+    } catch (Method::ParseError &e) {
+        QMessageBox::warning(this, "Request Parse Error", QString::fromStdString(e.getMessage()));
+        return;
+    }
+    std::unique_ptr<grpc::ByteBuffer> request = GrpcUtility::serializeMessage(*reqMessage);
+
+    // Parse request metadata
+    const auto metadata = getMetadata();
+    if (!metadata) {
+        return;
+    }
+    Session::Metadata values;
+    for (auto iter = metadata->cbegin(); iter != metadata->cend(); iter++) {
+        values.insert(iter.key(), iter.value());
+    }
+
+    auto channel = ChannelPool::shared().acquire(*server, certificates);
+    auto dialog = new BenchmarkDialog(*method, channel, values, *request, this);
+    dialog->show();
+}
+
+void Editor::onResponseListCurrentChanged(const QModelIndex &current) {
+    if (!current.isValid()) {
+        setResponseText(QString());
+        return;
+    }
+    showResponse(current.row());
+}
+
+void Editor::onResponseRendered(const std::shared_ptr<QTextDocument> &document,
+                                const std::shared_ptr<const google::protobuf::Message> &message) {
+    // 前のドキュメントは差し替えた後で手放す
+    ui.responseEdit->setDocument(document.get());
+    responseDocument = document;
+    responseHighlighter->documentReplaced();
+    // 木の節は展開された時に作るので、ここではメッセージを渡すだけで済む
+    responseTreeModel->setMessage(message);
 }
 
-void Editor::onLastResponseBodyButtonClicked() {
-    ui.responseBodyPageSpin->setValue(responses.size());
-    updateResponsePager();
+void Editor::onOpenResponseLogButtonClicked() {
+    if (session != nullptr) {
+        return;
+    }
+
+    const auto logDirectory = sharedPref().read<QString>([](const florarpc::Preferences &prefs) {
+        return QString::fromStdString(prefs.response_log_directory());
+    });
+    const auto path =
+        QFileDialog::getOpenFileName(this, "レスポンスログを開く", logDirectory,
+                                     QString("FloraRPC Response Log (*.%1)").arg(ResponseLog::fileExtension));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    clearResponseView();
+    if (!responses.openLog(path)) {
+        QMessageBox::warning(this, "Open Error", "レスポンスログを開けませんでした");
+    } else if (responses.logMethodName() != QString::fromStdString(method->getFullName())) {
+        QMessageBox::warning(this, "Open Error",
+                             QString("%1 のログなので、このメソッドでは開けません").arg(responses.logMethodName()));
+        responses.clear();
+    } else {
+        responseIndexer->addLogAsync(path);
+    }
+    responseListModel->reset();
+    if (!responses.isEmpty()) {
+        showResponseBodyTab();
+        selectResponse(0);
+    }
+}
+
+void Editor::onExportResponsesButtonClicked() {
+    if (responses.isEmpty()) {
+        return;
+    }
+
+    const QString ndjsonFilter = "NDJSON (*.ndjson *.jsonl)";
+    const QString csvFilter = "CSV (*.csv)";
+    const QString delimitedFilter = "Length-delimited Protobuf (*.binpb)";
+    QString selectedFilter;
+    const auto path = QFileDialog::getSaveFileName(this, "レスポンスを書き出す", "",
+                                                   QStringList({ndjsonFilter, csvFilter, delimitedFilter}).join(";;"),
+                                                   &selectedFilter);
+    if (path.isEmpty()) {
+        return;
+    }
+
+    auto format = Task::ExportResponsesTask::Format::NDJSON;
+    QStringList columns;
+    if (selectedFilter == csvFilter) {
+        format = Task::ExportResponsesTask::Format::CSV;
+        QStringList fields;
+        const auto type = method->getResponseType();
+        for (int i = 0; i < type->field_count(); i++) {
+            fields << QString::fromStdString(type->field(i)->name());
+        }
+        bool ok = false;
+        const auto text = QInputDialog::getText(
+            this, "CSVの列", "列にするフィールドをカンマ区切りで指定します。入れ子は field.sub_field のように書きます",
+            QLineEdit::Normal, fields.join(", "), &ok);
+        columns = text.split(',', Qt::SkipEmptyParts);
+        if (!ok || columns.isEmpty()) {
+            return;
+        }
+    } else if (selectedFilter == delimitedFilter) {
+        format = Task::ExportResponsesTask::Format::Delimited;
+    }
+
+    auto task = new Task::ExportResponsesTask(method, this);
+    connect(task, &Task::ExportResponsesTask::exported, this, [this](const QString &path, int written, int skipped) {
+        auto message = QString("%1件を %2 に書き出しました").arg(written).arg(path);
+        if (skipped > 0) {
+            message += QString("\n破棄済みなどで%1件は書き出せませんでした").arg(skipped);
+        }
+        QMessageBox::information(this, "Export", message);
+    });
+    connect(task, &Task::ExportResponsesTask::failed, this,
+            [this](const QString &message) { QMessageBox::warning(this, "Export Error", message); });
+    connect(task, &Task::ExportResponsesTask::finished, task, &QObject::deleteLater);
+    // 書き出している間も受信は続くので、今の中身を切り出して渡す
+    task->exportAsync(responses.snapshot(), path, format, columns);
+}
+
+void Editor::onResponseListContextMenuRequested(const QPoint &pos) {
+    auto selected = ui.responseListView->selectionModel()->selectedRows();
+    if (selected.size() != 2) {
+        return;
+    }
+    // 先に受信した方を基準にする
+    std::sort(selected.begin(), selected.end());
+
+    QMenu menu;
+    menu.addAction("選択した2件を比較(&C)", [&]() {
+        grpc::ByteBuffer left, right;
+        QString leftLabel, rightLabel;
+        if (!readResponse(selected[0].row(), left, leftLabel) || !readResponse(selected[1].row(), right, rightLabel)) {
+            return;
+        }
+        (new ResponseDiffDialog(method, left, leftLabel, right, rightLabel, this))->show();
+    });
+    menu.exec(ui.responseListView->viewport()->mapToGlobal(pos));
+}
+
+void Editor::onResponseSearchReturnPressed() {
+    const auto hits = responseIndexer->search(ui.responseSearchEdit->text());
+    if (hits.empty()) {
+        ui.responseSearchLabel->setText(ui.responseSearchEdit->text().trimmed().isEmpty() ? "" : "見つかりません");
+        return;
+    }
+
+    // 選択中のものより後ろへ進み、最後まで行ったら先頭に戻る
+    auto next = std::upper_bound(hits.begin(), hits.end(), ui.responseListView->currentIndex().row());
+    if (next == hits.end()) {
+        next = hits.begin();
+    }
+    ui.responseSearchLabel->setText(QString("%1 / %2件").arg(next - hits.begin() + 1).arg(hits.size()));
+    selectResponse(*next);
+}
+
+void Editor::onResponseProjectionEditingFinished() {
+    // 警告のダイアログでフォーカスが外れると、もう一度呼ばれてしまう
+    if (!ui.responseProjectionEdit->isModified()) {
+        return;
+    }
+    ui.responseProjectionEdit->setModified(false);
+
+    QStringList paths;
+    for (const auto &path : ui.responseProjectionEdit->text().split(',')) {
+        if (!path.trimmed().isEmpty()) {
+            paths.append(path.trimmed());
+        }
+    }
+    if (paths == (responseProjection ? responseProjection->getPaths() : QStringList())) {
+        return;
+    }
+
+    std::shared_ptr<const ResponseProjection> projection;
+    if (!paths.isEmpty()) {
+        QString error;
+        projection = ResponseProjection::create(method->getResponseType(), paths, error);
+        if (!projection) {
+            QMessageBox::warning(this, "Projection Error", error);
+            return;
+        }
+    }
+    responseProjection = projection;
+    responseListModel->setProjection(projection);
+    const auto current = ui.responseListView->currentIndex();
+    if (current.isValid()) {
+        showResponse(current.row());
+    }
+    willEmitWorkspaceModified();
 }
 
 void Editor::onMessageSent() {
@@ -335,22 +581,25 @@ void Editor::onMessageSent() {
     updateSendButton();
 }
 
-void Editor::onMessageReceived(const grpc::ByteBuffer &buffer) {
-    responses.append(buffer);
-
-    if (responses.size() == 1) {
-        ui.responseTabs->removeTab(ui.responseTabs->indexOf(ui.responseErrorTab));
-        ui.responseTabs->insertTab(0, ui.responseBodyTab, "Body");
-        ui.responseTabs->setCurrentIndex(0);
-        onResponseBodyPageChanged(1);
+void Editor::onMessagesReceived() {
+    QVector<qint64> receivedAt;
+    auto messages = session->takeMessages(receivedAt);
+    const auto previousSize = responses.size();
+    if (method->isServerStreaming()) {
+        responseIndexer->addAsync(previousSize, messages);
     }
+    responses.append(messages, receivedAt);
+    responseListModel->sync();
 
-    updateResponsePager();
+    if (previousSize == 0) {
+        showResponseBodyTab();
+        selectResponse(0);
+    }
 
     if (method->isServerStreaming() && ui.followResponseCheck->isChecked()) {
-        auto current = ui.responseBodyPageSpin->value();
-        if (current == responses.size() - 1) {
-            ui.responseBodyPageSpin->setValue(responses.size());
+        // 最新を見ている間だけ追いかける
+        if (ui.responseListView->currentIndex().row() == std::max(previousSize - 1, 0)) {
+            selectResponse(responses.size() - 1);
         }
     }
 
@@ -359,6 +608,8 @@ void Editor::onMessageReceived(const grpc::ByteBuffer &buffer) {
     }
 }
 
+void Editor::onReadPausedChanged(bool paused) { ui.readPausedLabel->setText(paused ? "受信停止中" : ""); }
+
 void Editor::onMetadataReceived(const Session::Metadata &metadata) {
     for (auto iter = metadata.cbegin(); iter != metadata.cend(); iter++) {
         addMetadataRow(iter.key(), iter.value());
@@ -374,8 +625,8 @@ void Editor::onSessionFinished(int code, const QString &message, const QByteArra
     if (code != grpc::StatusCode::OK) {
         QString formattedDetails = details;
         if (!details.isEmpty()) {
-            google::protobuf::DynamicMessageFactory dmf;
-            const auto status = method->parseErrorDetails(dmf, details.toStdString());
+            google::protobuf::Arena arena;
+            const auto status = method->parseErrorDetails(details.toStdString(), arena);
             if (status) {
                 std::string out;
                 // TODO: JSONにしたい気持ちはあるけど、Anyの解決に失敗した時に何も出力されないのが困るから妥協した
@@ -392,9 +643,8 @@ void Editor::onSessionFinished(int code, const QString &message, const QByteArra
     }
 
     const auto elapsed = session->getEndTime() - session->getBeginTime();
-    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(elapsed).count();
-    const auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() % 1000000;
-    ui.responseElapsedLabel->setText(QString("%1.%2s").arg(secs).arg(nsecs));
+    ui.responseElapsedLabel->setText(QString("%1s").arg(std::chrono::duration<double>(elapsed).count(), 0, 'f', 3));
+    ui.responseTimingView->setTimeline(session->getTimeline());
 
     cleanupSession();
 }
@@ -402,6 +652,7 @@ void Editor::onSessionFinished(int code, const QString &message, const QByteArra
 void Editor::cleanupSession() {
     delete session;
     session = nullptr;
+    ui.readPausedLabel->clear();
     disableStreamingButtons();
     updateSendButton();
     updateCancelButton();
@@ -429,12 +680,59 @@ void Editor::addMetadataRow(const QString &key, const QString &value) {
 
 void Editor::clearResponseView() {
     ui.responseElapsedLabel->clear();
-    ui.responseEdit->clear();
+    ui.responseTimingView->clear();
+    setResponseText(QString());
+    responseIndexer->clear();
+    ui.responseSearchLabel->clear();
     ui.responseMetadataTable->clearContents();
     ui.responseMetadataTable->setRowCount(0);
     ui.responseTabs->setTabText(ui.responseTabs->indexOf(ui.responseMetadataTab), "Metadata");
 }
 
+void Editor::showResponse(int index) {
+    grpc::ByteBuffer buffer;
+    if (!responses.read(index, buffer)) {
+        setResponseText("(このレスポンスは保持数の上限を超えたため破棄されました)");
+        return;
+    }
+    // 大きなメッセージでも固まらないよう、デコードからドキュメントの構築までをワーカーで行う
+    // 出来上がるまでは前の表示を残しておく
+    responseRenderer->renderAsync(buffer, ui.responseEdit->font(), responseProjection);
+}
+
+void Editor::setResponseText(const QString &text) {
+    responseRenderer->cancel();
+    ui.responseEdit->setPlainText(text);
+    responseTreeModel->clear();
+}
+
+void Editor::selectResponse(int index) {
+    const auto modelIndex = responseListModel->index(index);
+    ui.responseListView->setCurrentIndex(modelIndex);
+    ui.responseListView->scrollTo(modelIndex);
+}
+
+bool Editor::readResponse(int index, grpc::ByteBuffer &buffer, QString &label) {
+    if (index < 0) {
+        return false;
+    }
+    qint64 receivedAt;
+    if (!responses.read(index, buffer, &receivedAt)) {
+        QMessageBox::warning(this, "Compare Error", "このレスポンスは保持数の上限を超えたため破棄されました");
+        return false;
+    }
+    label = QString("#%1  %2")
+                .arg(index + 1)
+                .arg(QDateTime::fromMSecsSinceEpoch(receivedAt).toString("HH:mm:ss.zzz"));
+    return true;
+}
+
+void Editor::showResponseBodyTab() {
+    ui.responseTabs->removeTab(ui.responseTabs->indexOf(ui.responseErrorTab));
+    ui.responseTabs->insertTab(0, ui.responseBodyTab, "Body");
+    ui.responseTabs->setCurrentIndex(0);
+}
+
 void Editor::setErrorToResponseView(const QString &code, const QString &message, const QString &details) {
     ui.errorCodeLabel->setText(code);
     ui.errorMessageLabel->setText(message);
@@ -445,7 +743,12 @@ void Editor::setErrorToResponseView(const QString &code, const QString &message,
     ui.responseTabs->setCurrentIndex(0);
 }
 
-void Editor::updateServerSelectBox() { ui.serverSelectBox->setDisabled(session != nullptr || servers.empty()); }
+void Editor::updateServerSelectBox() {
+    ui.serverSelectBox->setDisabled(session != nullptr || servers.empty());
+    ui.reconnectButton->setDisabled(session != nullptr || servers.empty());
+    ui.openResponseLogButton->setDisabled(session != nullptr);
+    ui.benchmarkButton->setDisabled(servers.empty());
+}
 
 void Editor::updateSendButton() {
     bool disabled = false;
@@ -479,30 +782,6 @@ void Editor::enableStreamingButtons() {
 
 void Editor::disableStreamingButtons() { ui.finishButton->setDisabled(true); }
 
-void Editor::updateResponsePager() {
-    ui.responseBodyPager->setDisabled(false);
-    ui.responseBodyPageSpin->setMaximum(responses.isEmpty() ? 1 : responses.size());
-    ui.responseBodyMaxPageLabel->setText(QString("%1").arg(responses.size()));
-
-    if (responses.isEmpty()) {
-        ui.prevResponseBodyButton->setDisabled(true);
-        ui.nextResponseBodyButton->setDisabled(true);
-        ui.lastResponseBodyButton->setDisabled(true);
-    } else {
-        ui.prevResponseBodyButton->setDisabled(false);
-        ui.nextResponseBodyButton->setDisabled(false);
-        ui.lastResponseBodyButton->setDisabled(false);
-    }
-
-    if (ui.responseBodyPageSpin->value() <= 1) {
-        ui.prevResponseBodyButton->setDisabled(true);
-    }
-    if (ui.responseBodyPageSpin->value() == responses.size()) {
-        ui.nextResponseBodyButton->setDisabled(true);
-        ui.lastResponseBodyButton->setDisabled(true);
-    }
-}
-
 std::shared_ptr<Server> Editor::getCurrentServer() {
     if (servers.empty()) {
         return nullptr;
@@ -11,8 +11,14 @@
 
 #include "../entity/Certificate.h"
 #include "../entity/Method.h"
+#include "../entity/ResponseStore.h"
 #include "../entity/Server.h"
 #include "../entity/Session.h"
+#include "ResponseListModel.h"
+#include "ResponseTreeModel.h"
+#include "task/IndexResponsesTask.h"
+#include "task/RenderResponseTask.h"
+#include "util/JsonHighlighter.h"
 #include "florarpc/workspace.pb.h"
 #include "ui/ui_Editor.h"
 
@@ -46,19 +52,36 @@ private slots:
 
     void onCancelButtonClicked();
 
-    void onResponseBodyPageChanged(int page);
+    void onPauseReadingButtonToggled(bool checked);
 
-    void onPrevResponseBodyButtonClicked();
+    void onStreamBufferSpinChanged(int value);
 
-    void onNextResponseBodyButtonClicked();
+    void onReconnectButtonClicked();
 
-    void onLastResponseBodyButtonClicked();
+    void onBenchmarkButtonClicked();
+
+    void onResponseListCurrentChanged(const QModelIndex &current);
+
+    void onResponseRendered(const std::shared_ptr<QTextDocument> &document,
+                            const std::shared_ptr<const google::protobuf::Message> &message);
+
+    void onOpenResponseLogButtonClicked();
+
+    void onExportResponsesButtonClicked();
+
+    void onResponseListContextMenuRequested(const QPoint &pos);
+
+    void onResponseSearchReturnPressed();
+
+    void onResponseProjectionEditingFinished();
 
     void onMessageSent();
 
+    void onReadPausedChanged(bool paused);
+
     void onMetadataReceived(const Session::Metadata &metadata);
 
-    void onMessageReceived(const grpc::ByteBuffer &buffer);
+    void onMessagesReceived();
 
     void onSessionFinished(int code, const QString &message, const QByteArray &details);
 
@@ -71,20 +94,45 @@ private:
     QMenu *responseMetadataContextMenu;
     Session *session;
     bool sendingRequest;
-    QVector<grpc::ByteBuffer> responses;
-
-    std::unique_ptr<Method> method;
+    ResponseStore responses;
+
+    // 描画中のワーカーからも参照される
+    std::shared_ptr<Method> method;
+    ResponseListModel *responseListModel;
+    ResponseTreeModel *responseTreeModel;
+    Task::RenderResponseTask *responseRenderer;
+    Task::IndexResponsesTask *responseIndexer;
+    // responseEditに表示中の、ワーカーが作ったドキュメント
+    std::shared_ptr<QTextDocument> responseDocument;
     std::vector<std::shared_ptr<Server>> servers;
     std::vector<std::shared_ptr<Certificate>> certificates;
+    // 比較の基準にしたレスポンス。実行し直しても残る
+    std::optional<grpc::ByteBuffer> diffBaseline;
+    QString diffBaselineLabel;
+    // 表示するフィールドの絞り込み。nullptrなら全て表示する
+    std::shared_ptr<const ResponseProjection> responseProjection;
 
-    std::unique_ptr<KSyntaxHighlighting::SyntaxHighlighter> requestHighlighter;
+    std::unique_ptr<JsonHighlighter> requestHighlighter;
     std::unique_ptr<KSyntaxHighlighting::SyntaxHighlighter> requestMetadataHighlighter;
-    std::unique_ptr<KSyntaxHighlighting::SyntaxHighlighter> responseHighlighter;
+    std::unique_ptr<JsonHighlighter> responseHighlighter;
 
     void addMetadataRow(const QString &key, const QString &value);
 
     void clearResponseView();
 
+    void showResponse(int index);
+
+    void setResponseText(const QString &text);
+
+    void selectResponse(int index);
+
+    /**
+     * labelには比較の画面で使う、何番目のいつのレスポンスかを入れる
+     */
+    bool readResponse(int index, grpc::ByteBuffer &buffer, QString &label);
+
+    void showResponseBodyTab();
+
     void setErrorToResponseView(const QString &code, const QString &message, const QString &details);
 
     void updateServerSelectBox();
@@ -96,8 +144,6 @@ private:
     void enableStreamingButtons();
 
     void disableStreamingButtons();
-
-    void updateResponsePager();
 };
 
 #endif  // FLORARPC_EDITOR_H
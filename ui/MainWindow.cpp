@@ -14,10 +14,12 @@
 #include <QStandardPaths>
 #include <QStyle>
 #include <QTextStream>
+#include <QThreadPool>
 #include <chrono>
 
 #include "AboutDialog.h"
 #include "ImportsManageDialog.h"
+#include "PreferencesDialog.h"
 #include "ServersManageDialog.h"
 #include "entity/Preferences.h"
 #include "event/WorkspaceModifiedEvent.h"
@@ -52,6 +54,10 @@ MainWindow::MainWindow(QWidget *parent)
         AboutDialog dialog;
         dialog.exec();
     });
+    connect(ui.actionPreferences, &QAction::triggered, [=]() {
+        PreferencesDialog dialog(this);
+        dialog.exec();
+    });
     connect(ui.actionQuit, &QAction::triggered, this, &MainWindow::close);
     connect(ui.actionCopyAsGrpcurl, &QAction::triggered, this, &MainWindow::onActionCopyAsGrpcurlTriggered);
     connect(ui.actionOpenCopyAsUserScriptDir, &QAction::triggered, this,
@@ -289,8 +295,7 @@ void MainWindow::onActionOpenCopyAsUserScriptDirTriggered() {
 
 void MainWindow::onAsyncLoadFinished(const QList<std::shared_ptr<Protocol>> &protocols, bool hasError) {
     for (const auto &protocol : protocols) {
-        this->protocols.push_back(protocol);
-        protocolTreeModel->addProtocol(protocol);
+        addProtocol(protocol);
     }
 
     if (hasError) {
@@ -456,12 +461,23 @@ bool MainWindow::openProtos(const QStringList &filenames, bool abortOnLoadError)
         }
     }
     for (const auto &protocol : successes) {
-        protocols.push_back(protocol);
-        protocolTreeModel->addProtocol(protocol);
+        addProtocol(protocol);
     }
     return true;
 }
 
+void MainWindow::addProtocol(const std::shared_ptr<Protocol> &protocol) {
+    protocols.push_back(protocol);
+    protocolTreeModel->addProtocol(protocol);
+
+    const auto skipWarmUp =
+        sharedPref().read<bool>([](const florarpc::Preferences &prefs) { return prefs.skip_prototype_warm_up(); });
+    if (!skipWarmUp) {
+        // 最初の送信や表示でプロトタイプの生成を待たなくて済むように
+        QThreadPool::globalInstance()->start([protocol]() { protocol->warmUpPrototypes(); });
+    }
+}
+
 void MainWindow::openMethod(const QModelIndex &index, bool forceNewTab) {
     if (!index.parent().isValid() || !index.flags().testFlag(Qt::ItemFlag::ItemIsSelectable)) {
         // disabled node
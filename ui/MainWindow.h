@@ -79,6 +79,7 @@ private:
     QTimer workspaceSaveTimer;
 
     bool openProtos(const QStringList &filenames, bool abortOnLoadError);
+    void addProtocol(const std::shared_ptr<Protocol> &protocol);
     void openMethod(const QModelIndex &index, bool forceNewTab);
     Editor *openEditor(std::unique_ptr<Method> method, bool forceNewTab);
     bool saveWorkspace(const QString &filename);
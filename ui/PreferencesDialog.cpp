@@ -0,0 +1,61 @@
+#include "PreferencesDialog.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QPushButton>
+
+#include "entity/Preferences.h"
+#include "entity/ResponseStore.h"
+
+static constexpr qint64 bytesPerMegabyte = 1024 * 1024;
+
+PreferencesDialog::PreferencesDialog(QWidget *parent)
+    : QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint) {
+    ui.setupUi(this);
+
+    connect(ui.responseLogDirectoryButton, &QPushButton::clicked, this,
+            &PreferencesDialog::onResponseLogDirectoryButtonClick);
+    connect(ui.buttonBox->button(QDialogButtonBox::Ok), &QAbstractButton::clicked, this,
+            &PreferencesDialog::onOkButtonClick);
+    connect(ui.buttonBox->button(QDialogButtonBox::Cancel), &QAbstractButton::clicked, this,
+            &PreferencesDialog::onCancelButtonClick);
+
+    sharedPref().read([this](const florarpc::Preferences &prefs) {
+        // 0は既定値を表すので、実際に使われる値を見せる
+        const auto maxMessages = prefs.response_memory_max_messages();
+        ui.responseMemoryMaxMessagesSpin->setValue(maxMessages > 0 ? maxMessages : ResponseStore::defaultMaxMessages);
+        const auto maxBytes = prefs.response_memory_max_bytes();
+        ui.responseMemoryMaxMegabytesSpin->setValue(
+            static_cast<int>((maxBytes > 0 ? maxBytes : ResponseStore::defaultMaxBytes) / bytesPerMegabyte));
+        ui.discardOverflowedResponsesCheck->setChecked(prefs.discard_overflowed_responses());
+        ui.responseLogDirectoryEdit->setText(QString::fromStdString(prefs.response_log_directory()));
+    });
+}
+
+void PreferencesDialog::onResponseLogDirectoryButtonClick() {
+    const auto directory =
+        QFileDialog::getExistingDirectory(this, "ログの保存先を選択", ui.responseLogDirectoryEdit->text());
+    if (!directory.isEmpty()) {
+        ui.responseLogDirectoryEdit->setText(QDir::toNativeSeparators(directory));
+    }
+}
+
+void PreferencesDialog::onOkButtonClick() {
+    // 作れないと黙って一時ファイルへの退避に戻ってしまうので、ここで確かめる
+    const auto logDirectory = ui.responseLogDirectoryEdit->text().trimmed();
+    if (!logDirectory.isEmpty() && !QDir(logDirectory).exists()) {
+        QMessageBox::warning(this, "Error", "ログの保存先のフォルダがありません。");
+        return;
+    }
+
+    sharedPref().mutation([this, &logDirectory](florarpc::Preferences &prefs) {
+        prefs.set_response_memory_max_messages(ui.responseMemoryMaxMessagesSpin->value());
+        prefs.set_response_memory_max_bytes(ui.responseMemoryMaxMegabytesSpin->value() * bytesPerMegabyte);
+        prefs.set_discard_overflowed_responses(ui.discardOverflowedResponsesCheck->isChecked());
+        prefs.set_response_log_directory(QDir::fromNativeSeparators(logDirectory).toStdString());
+    });
+    done(Accepted);
+}
+
+void PreferencesDialog::onCancelButtonClick() { done(Rejected); }
@@ -0,0 +1,28 @@
+#ifndef FLORARPC_PREFERENCESDIALOG_H
+#define FLORARPC_PREFERENCESDIALOG_H
+
+#include <QDialog>
+
+#include "ui/ui_PreferencesDialog.h"
+
+/**
+ * 環境設定のうち、画面から変えられるものを編集する。OKで保存する
+ */
+class PreferencesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit PreferencesDialog(QWidget *parent = nullptr);
+
+private slots:
+    void onResponseLogDirectoryButtonClick();
+
+    void onOkButtonClick();
+
+    void onCancelButtonClick();
+
+private:
+    Ui::PreferencesDialog ui;
+};
+
+#endif  // FLORARPC_PREFERENCESDIALOG_H
@@ -0,0 +1,69 @@
+#include "ResponseDiffDialog.h"
+
+#include <QFontDatabase>
+#include <QMessageBox>
+
+static QStringList splitList(const QString &text) {
+    QStringList items;
+    for (const auto &item : text.split(',', Qt::SkipEmptyParts)) {
+        if (!item.trimmed().isEmpty()) {
+            items << item.trimmed();
+        }
+    }
+    return items;
+}
+
+ResponseDiffDialog::ResponseDiffDialog(std::shared_ptr<Method> method, const grpc::ByteBuffer &left,
+                                       const QString &leftLabel, const grpc::ByteBuffer &right,
+                                       const QString &rightLabel, QWidget *parent)
+    : QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowMaximizeButtonHint |
+                          Qt::WindowCloseButtonHint),
+      model(new ResponseDiffModel(this)),
+      task(new Task::DiffResponsesTask(method, this)),
+      method(std::move(method)),
+      left(left),
+      right(right) {
+    ui.setupUi(this);
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle(QString("レスポンスの比較 - %1  %2 → %3")
+                       .arg(QString::fromStdString(this->method->getFullName()), leftLabel, rightLabel));
+
+    connect(ui.compareButton, &QPushButton::clicked, this, &ResponseDiffDialog::onCompareButtonClicked);
+    connect(task, &Task::DiffResponsesTask::diffed, this, &ResponseDiffDialog::onDiffed);
+
+    model->setLabels(leftLabel, rightLabel);
+    ui.diffView->setModel(model);
+    ui.diffView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    onCompareButtonClicked();
+}
+
+void ResponseDiffDialog::onCompareButtonClicked() {
+    ResponseDiff::Options options;
+    options.keys = splitList(ui.keysEdit->text());
+    options.ignoredPaths = splitList(ui.ignoredPathsEdit->text());
+    options.floatMargin = ui.floatMarginSpin->value();
+    if (const auto error = ResponseDiff::checkOptions(method->getResponseType(), options); !error.isEmpty()) {
+        QMessageBox::warning(this, "Compare Error", error);
+        return;
+    }
+
+    ui.statusLabel->setText("比較しています...");
+    task->diffAsync(left, right, options);
+}
+
+void ResponseDiffDialog::onDiffed(const std::shared_ptr<const ResponseDiff> &diff) {
+    model->setDiff(diff);
+    // 節の数には上限があるので、全部開いても重くはならない
+    ui.diffView->expandAll();
+    ui.diffView->resizeColumnToContents(0);
+
+    if (diff->getDifferenceCount() == 0) {
+        ui.statusLabel->setText("違いはありません");
+    } else if (diff->isTruncated()) {
+        ui.statusLabel->setText(
+            QString("%1箇所以上の違いがあります。多すぎるため、途中から省略しました").arg(diff->getDifferenceCount()));
+    } else {
+        ui.statusLabel->setText(QString("%1箇所の違いがあります").arg(diff->getDifferenceCount()));
+    }
+}
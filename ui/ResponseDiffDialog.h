@@ -0,0 +1,34 @@
+#ifndef FLORARPC_RESPONSEDIFFDIALOG_H
+#define FLORARPC_RESPONSEDIFFDIALOG_H
+
+#include <QDialog>
+
+#include "ResponseDiffModel.h"
+#include "entity/Method.h"
+#include "task/DiffResponsesTask.h"
+#include "ui/ui_ResponseDiffDialog.h"
+
+class ResponseDiffDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ResponseDiffDialog(std::shared_ptr<Method> method, const grpc::ByteBuffer &left, const QString &leftLabel,
+                       const grpc::ByteBuffer &right, const QString &rightLabel, QWidget *parent = nullptr);
+
+private slots:
+
+    void onCompareButtonClicked();
+
+    void onDiffed(const std::shared_ptr<const ResponseDiff> &diff);
+
+private:
+    Ui::ResponseDiffDialog ui;
+    ResponseDiffModel *model;
+    Task::DiffResponsesTask *task;
+
+    std::shared_ptr<Method> method;
+    grpc::ByteBuffer left;
+    grpc::ByteBuffer right;
+};
+
+#endif  // FLORARPC_RESPONSEDIFFDIALOG_H
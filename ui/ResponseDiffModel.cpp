@@ -0,0 +1,122 @@
+#include "ResponseDiffModel.h"
+
+#include <QColor>
+
+using Node = ResponseDiff::Node;
+
+ResponseDiffModel::ResponseDiffModel(QObject *parent)
+    : QAbstractItemModel(parent), leftLabel("比較元"), rightLabel("比較先") {}
+
+void ResponseDiffModel::setDiff(std::shared_ptr<const ResponseDiff> diff) {
+    beginResetModel();
+    this->diff = std::move(diff);
+    endResetModel();
+}
+
+void ResponseDiffModel::setLabels(const QString &left, const QString &right) {
+    leftLabel = left;
+    rightLabel = right;
+    emit headerDataChanged(Qt::Horizontal, 1, 2);
+}
+
+void ResponseDiffModel::clear() {
+    beginResetModel();
+    diff.reset();
+    endResetModel();
+}
+
+QModelIndex ResponseDiffModel::index(int row, int column, const QModelIndex &parent) const {
+    if (column < 0 || column >= columnCount(parent) || (parent.isValid() && parent.column() != 0)) {
+        return QModelIndex();
+    }
+
+    const auto node = parent.isValid() ? indexToNode(parent) : diff ? &diff->getRoot() : nullptr;
+    if (node == nullptr || row < 0 || row >= static_cast<int>(node->children.size())) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, node->children[row].get());
+}
+
+QModelIndex ResponseDiffModel::parent(const QModelIndex &child) const {
+    if (!child.isValid()) {
+        return QModelIndex();
+    }
+
+    const auto node = indexToNode(child);
+    if (node->parent == nullptr || node->parent == &diff->getRoot()) {
+        return QModelIndex();
+    }
+    return createIndex(node->parent->row, 0, node->parent);
+}
+
+int ResponseDiffModel::rowCount(const QModelIndex &parent) const {
+    if (parent.column() > 0) {
+        return 0;
+    }
+
+    const auto node = parent.isValid() ? indexToNode(parent) : diff ? &diff->getRoot() : nullptr;
+    return node != nullptr ? node->children.size() : 0;
+}
+
+int ResponseDiffModel::columnCount(const QModelIndex &parent) const { return 3; }
+
+QVariant ResponseDiffModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    const auto node = indexToNode(index);
+    if (role == Qt::BackgroundRole) {
+        // 配色に関わらず読めるよう、半透明で重ねる
+        switch (node->kind) {
+            case Node::Parent:
+                return QVariant();
+            case Node::Added:
+                return QColor(0, 192, 0, 48);
+            case Node::Deleted:
+                return QColor(224, 0, 0, 48);
+            case Node::Modified:
+                return QColor(224, 192, 0, 64);
+        }
+        return QVariant();
+    }
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+        case 0:
+            return node->label;
+        case 1:
+            return node->left;
+        case 2:
+            return node->right;
+    }
+    return QVariant();
+}
+
+QVariant ResponseDiffModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    switch (section) {
+        case 0:
+            return QString("フィールド");
+        case 1:
+            return leftLabel;
+        case 2:
+            return rightLabel;
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags ResponseDiffModel::flags(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return QAbstractItemModel::flags(index);
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+const ResponseDiff::Node *ResponseDiffModel::indexToNode(const QModelIndex &index) const {
+    return static_cast<const Node *>(index.internalPointer());
+}
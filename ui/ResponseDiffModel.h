@@ -0,0 +1,47 @@
+#ifndef FLORARPC_RESPONSEDIFFMODEL_H
+#define FLORARPC_RESPONSEDIFFMODEL_H
+
+#include <QAbstractItemModel>
+#include <memory>
+
+#include "entity/ResponseDiff.h"
+
+/**
+ * ResponseDiffの木を、フィールドと左右の値の3列で見せる
+ */
+class ResponseDiffModel : public QAbstractItemModel {
+public:
+    explicit ResponseDiffModel(QObject *parent);
+
+    void setDiff(std::shared_ptr<const ResponseDiff> diff);
+
+    /**
+     * 値の列の見出し
+     */
+    void setLabels(const QString &left, const QString &right);
+
+    void clear();
+
+    QModelIndex index(int row, int column, const QModelIndex &parent) const override;
+
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent) const override;
+
+    int columnCount(const QModelIndex &parent) const override;
+
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+private:
+    std::shared_ptr<const ResponseDiff> diff;
+    QString leftLabel;
+    QString rightLabel;
+
+    const ResponseDiff::Node *indexToNode(const QModelIndex &index) const;
+};
+
+#endif  // FLORARPC_RESPONSEDIFFMODEL_H
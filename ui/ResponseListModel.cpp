@@ -0,0 +1,86 @@
+#include "ResponseListModel.h"
+
+#include <QDateTime>
+#include <QLocale>
+
+// 要約を作った行のうち、覚えておく件数。表示中の行が収まれば足りる
+static constexpr int summaryCacheSize = 2000;
+// 要約は描画の中でGUIスレッドがデコードするので、これより大きなメッセージは中身を見ない
+// 1画面分の行を合わせても、スクロールを止めない程度の量に収める
+static constexpr size_t maxSummarizeBytes = 64 * 1024;
+
+ResponseListModel::ResponseListModel(ResponseStore &store, Method &method, QObject *parent)
+    : QAbstractListModel(parent), store(store), method(method), summaries(summaryCacheSize) {}
+
+void ResponseListModel::sync() {
+    const int size = store.size();
+    if (size < rows) {
+        reset();
+        return;
+    }
+    if (size == rows) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), rows, size - 1);
+    rows = size;
+    endInsertRows();
+}
+
+void ResponseListModel::reset() {
+    beginResetModel();
+    summaries.clear();
+    rows = store.size();
+    endResetModel();
+}
+
+void ResponseListModel::setProjection(std::shared_ptr<const ResponseProjection> projection) {
+    this->projection = std::move(projection);
+    summaries.clear();
+    // 選択を保つため、リセットせずに全ての行を書き換えたことにする
+    if (rows > 0) {
+        emit dataChanged(index(0), index(rows - 1), {Qt::DisplayRole});
+    }
+}
+
+int ResponseListModel::rowCount(const QModelIndex &parent) const { return parent.isValid() ? 0 : rows; }
+
+QVariant ResponseListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= rows || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (const auto cached = summaries.object(index.row())) {
+        return *cached;
+    }
+    const auto summary = summarize(index.row());
+    summaries.insert(index.row(), new QString(summary));
+    return summary;
+}
+
+QString ResponseListModel::summarize(int row) const {
+    // 1行に収まれば十分なので、それ以上は書き出さない
+    constexpr int summaryLength = 200;
+
+    const auto number = QString("#%1").arg(row + 1);
+    grpc::ByteBuffer buffer;
+    qint64 receivedAt;
+    if (!store.read(row, buffer, &receivedAt)) {
+        return QString("%1  (破棄済み)").arg(number);
+    }
+
+    QString json;
+    if (buffer.Length() <= maxSummarizeBytes) {
+        google::protobuf::Arena arena;
+        const auto message = method.parseResponse(buffer, arena, projection.get());
+        bool truncated = false;
+        json = method.formatResponse(*message, summaryLength, truncated, projection.get()).simplified();
+        if (truncated) {
+            json += "…";
+        }
+    }
+
+    return QString("%1  %2  %3  %4")
+        .arg(number, QDateTime::fromMSecsSinceEpoch(receivedAt).toString("HH:mm:ss.zzz"),
+             QLocale().formattedDataSize(static_cast<qint64>(buffer.Length())), json);
+}
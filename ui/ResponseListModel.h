@@ -0,0 +1,47 @@
+#ifndef FLORARPC_RESPONSELISTMODEL_H
+#define FLORARPC_RESPONSELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <memory>
+
+#include "../entity/Method.h"
+#include "../entity/ResponseStore.h"
+
+/**
+ * ResponseStoreの1件を1行で見せる。要約は表示される行についてだけ、必要になった時にデコードして作る
+ */
+class ResponseListModel : public QAbstractListModel {
+public:
+    ResponseListModel(ResponseStore &store, Method &method, QObject *parent);
+
+    /**
+     * ストアに追加された分の行を増やす
+     */
+    void sync();
+
+    /**
+     * ストアをclearした時や、ログを開いた時に呼ぶ
+     */
+    void reset();
+
+    /**
+     * 要約に出すフィールドを絞る。nullptrなら全て出す
+     */
+    void setProjection(std::shared_ptr<const ResponseProjection> projection);
+
+    int rowCount(const QModelIndex &parent) const override;
+
+    QVariant data(const QModelIndex &index, int role) const override;
+
+private:
+    ResponseStore &store;
+    Method &method;
+    std::shared_ptr<const ResponseProjection> projection;
+    int rows = 0;
+    mutable QCache<int, QString> summaries;
+
+    QString summarize(int row) const;
+};
+
+#endif  // FLORARPC_RESPONSELISTMODEL_H
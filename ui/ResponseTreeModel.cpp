@@ -0,0 +1,276 @@
+#include "ResponseTreeModel.h"
+
+#include <google/protobuf/descriptor.h>
+
+#include <algorithm>
+
+#include "util/ProtobufField.h"
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+// 1つの節の下に直接並べる要素数。これを超えるrepeatedフィールドは範囲ごとの節に分ける
+static constexpr int chunkSize = 1000;
+// 値の列に出す文字列やバイト列の長さ
+static constexpr int maxValueLength = 1000;
+
+struct ResponseTreeModel::Node {
+    enum Type {
+        // 根。レスポンスそのもの
+        MessageNode,
+        FieldNode,
+        // repeatedフィールドの1要素。mapでは1エントリ
+        ElementNode,
+        // repeatedフィールドの [begin, end) の要素をまとめたもの
+        RangeNode,
+    };
+
+    Node *parent;
+    int row;
+    Type type;
+    // MessageNodeではそれ自身、それ以外ではfieldを持つメッセージ
+    const Message *message;
+    const FieldDescriptor *field;
+    int begin;
+    int end;
+    bool populated = false;
+    std::vector<std::unique_ptr<Node>> children;
+
+    Node(Node *parent, int row, Type type, const Message *message, const FieldDescriptor *field, int begin = 0,
+         int end = 0)
+        : parent(parent), row(row), type(type), message(message), field(field), begin(begin), end(end) {}
+
+    const Message &element() const { return message->GetReflection()->GetRepeatedMessage(*message, field, begin); }
+
+    /**
+     * 子としてフィールドを並べるメッセージ。無ければnullptr
+     */
+    const Message *childMessage() const {
+        switch (type) {
+            case MessageNode:
+                return message;
+            case FieldNode:
+                if (!field->is_repeated() && field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+                    return &message->GetReflection()->GetMessage(*message, field);
+                }
+                return nullptr;
+            case ElementNode:
+                if (field->is_map()) {
+                    const auto &entry = element();
+                    const auto valueField = field->message_type()->map_value();
+                    if (valueField->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+                        return &entry.GetReflection()->GetMessage(entry, valueField);
+                    }
+                    return nullptr;
+                }
+                if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+                    return &element();
+                }
+                return nullptr;
+            case RangeNode:
+                return nullptr;
+        }
+        return nullptr;
+    }
+
+    bool hasChildren() const {
+        switch (type) {
+            case MessageNode:
+            case RangeNode:
+                return true;
+            case FieldNode:
+                if (field->is_repeated()) {
+                    return message->GetReflection()->FieldSize(*message, field) > 0;
+                }
+                break;
+            case ElementNode:
+                break;
+        }
+        const auto child = childMessage();
+        return child != nullptr && child->GetDescriptor()->field_count() > 0;
+    }
+
+    void populate() {
+        if (populated) {
+            return;
+        }
+        populated = true;
+
+        if (type == RangeNode) {
+            populateRange(begin, end);
+        } else if (type == FieldNode && field->is_repeated()) {
+            populateRange(0, message->GetReflection()->FieldSize(*message, field));
+        } else if (const auto child = childMessage()) {
+            // JSONの表示と同じく、値の無いメッセージ型やoneofのフィールドだけを省く
+            const auto descriptor = child->GetDescriptor();
+            const auto reflection = child->GetReflection();
+            for (int i = 0; i < descriptor->field_count(); i++) {
+                const auto f = descriptor->field(i);
+                if (!f->is_repeated() && f->has_presence() && !reflection->HasField(*child, f)) {
+                    continue;
+                }
+                children.push_back(std::make_unique<Node>(this, children.size(), FieldNode, child, f));
+            }
+        }
+    }
+
+    void populateRange(int from, int to) {
+        if (to - from <= chunkSize) {
+            for (int i = from; i < to; i++) {
+                children.push_back(std::make_unique<Node>(this, children.size(), ElementNode, message, field, i));
+            }
+            return;
+        }
+
+        // 子の数がchunkSize以下になるまで、1つの範囲を広げる
+        long long step = chunkSize;
+        while ((to - from + step - 1) / step > chunkSize) {
+            step *= chunkSize;
+        }
+        for (long long i = from; i < to; i += step) {
+            const auto last = static_cast<int>(std::min<long long>(i + step, to));
+            children.push_back(
+                std::make_unique<Node>(this, children.size(), RangeNode, message, field, static_cast<int>(i), last));
+        }
+    }
+};
+
+static QString scalarToString(const Message &message, const FieldDescriptor *field, int index) {
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        return QString::fromStdString(field->message_type()->name());
+    }
+    return ProtobufField::toDisplayString(message, field, index, maxValueLength);
+}
+
+ResponseTreeModel::ResponseTreeModel(QObject *parent) : QAbstractItemModel(parent) {}
+
+ResponseTreeModel::~ResponseTreeModel() = default;
+
+void ResponseTreeModel::setMessage(std::shared_ptr<const google::protobuf::Message> message) {
+    beginResetModel();
+    root = std::make_unique<Node>(nullptr, 0, Node::MessageNode, message.get(), nullptr);
+    this->message = std::move(message);
+    endResetModel();
+}
+
+void ResponseTreeModel::clear() {
+    beginResetModel();
+    root.reset();
+    message.reset();
+    endResetModel();
+}
+
+QModelIndex ResponseTreeModel::index(int row, int column, const QModelIndex &parent) const {
+    if (column < 0 || column >= columnCount(parent) || (parent.isValid() && parent.column() != 0)) {
+        return QModelIndex();
+    }
+
+    const auto node = parent.isValid() ? indexToNode(parent) : root.get();
+    if (node == nullptr) {
+        return QModelIndex();
+    }
+    node->populate();
+    if (row < 0 || row >= static_cast<int>(node->children.size())) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, node->children[row].get());
+}
+
+QModelIndex ResponseTreeModel::parent(const QModelIndex &child) const {
+    if (!child.isValid()) {
+        return QModelIndex();
+    }
+
+    const auto node = indexToNode(child);
+    if (node->parent == nullptr || node->parent == root.get()) {
+        return QModelIndex();
+    }
+    return createIndex(node->parent->row, 0, node->parent);
+}
+
+int ResponseTreeModel::rowCount(const QModelIndex &parent) const {
+    if (parent.column() > 0) {
+        return 0;
+    }
+
+    const auto node = parent.isValid() ? indexToNode(parent) : root.get();
+    if (node == nullptr) {
+        return 0;
+    }
+    node->populate();
+    return node->children.size();
+}
+
+int ResponseTreeModel::columnCount(const QModelIndex &parent) const { return 2; }
+
+bool ResponseTreeModel::hasChildren(const QModelIndex &parent) const {
+    if (!parent.isValid()) {
+        return root != nullptr;
+    }
+    if (parent.column() > 0) {
+        return false;
+    }
+    // 展開されるまで子は作らない
+    return indexToNode(parent)->hasChildren();
+}
+
+QVariant ResponseTreeModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    const auto node = indexToNode(index);
+    const auto field = node->field;
+    if (index.column() == 0) {
+        switch (node->type) {
+            case Node::MessageNode:
+                return QVariant();
+            case Node::FieldNode:
+                return QString::fromStdString(field->json_name());
+            case Node::ElementNode:
+                if (field->is_map()) {
+                    return QString("[%1]").arg(scalarToString(node->element(), field->message_type()->map_key(), -1));
+                }
+                return QString("[%1]").arg(node->begin);
+            case Node::RangeNode:
+                return QString("[%1 - %2]").arg(node->begin).arg(node->end - 1);
+        }
+        return QVariant();
+    }
+
+    switch (node->type) {
+        case Node::MessageNode:
+            return QVariant();
+        case Node::FieldNode:
+            if (field->is_repeated()) {
+                return QString("%1件").arg(node->message->GetReflection()->FieldSize(*node->message, field));
+            }
+            return scalarToString(*node->message, field, -1);
+        case Node::ElementNode:
+            if (field->is_map()) {
+                return scalarToString(node->element(), field->message_type()->map_value(), -1);
+            }
+            return scalarToString(*node->message, field, node->begin);
+        case Node::RangeNode:
+            return QString("%1件").arg(node->end - node->begin);
+    }
+    return QVariant();
+}
+
+QVariant ResponseTreeModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    return section == 0 ? QString("フィールド") : QString("値");
+}
+
+Qt::ItemFlags ResponseTreeModel::flags(const QModelIndex &index) const {
+    if (!index.isValid()) {
+        return QAbstractItemModel::flags(index);
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+ResponseTreeModel::Node *ResponseTreeModel::indexToNode(const QModelIndex &index) const {
+    return static_cast<Node *>(index.internalPointer());
+}
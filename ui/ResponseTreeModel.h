@@ -0,0 +1,52 @@
+#ifndef FLORARPC_RESPONSETREEMODEL_H
+#define FLORARPC_RESPONSETREEMODEL_H
+
+#include <google/protobuf/message.h>
+
+#include <QAbstractItemModel>
+#include <memory>
+#include <vector>
+
+/**
+ * レスポンスをリフレクションでたどって木として見せる
+ * 子は展開された時に初めて作る。要素の多いrepeatedフィールドは、範囲ごとにまとめた節を挟む
+ */
+class ResponseTreeModel : public QAbstractItemModel {
+public:
+    explicit ResponseTreeModel(QObject *parent);
+
+    ~ResponseTreeModel() override;
+
+    /**
+     * messageはこのモデルが参照を持つ間、生きている必要がある
+     */
+    void setMessage(std::shared_ptr<const google::protobuf::Message> message);
+
+    void clear();
+
+    QModelIndex index(int row, int column, const QModelIndex &parent) const override;
+
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent) const override;
+
+    int columnCount(const QModelIndex &parent) const override;
+
+    bool hasChildren(const QModelIndex &parent) const override;
+
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+private:
+    struct Node;
+
+    std::shared_ptr<const google::protobuf::Message> message;
+    std::unique_ptr<Node> root;
+
+    Node *indexToNode(const QModelIndex &index) const;
+};
+
+#endif  // FLORARPC_RESPONSETREEMODEL_H
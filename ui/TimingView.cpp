@@ -0,0 +1,103 @@
+#include "TimingView.h"
+
+#include <QPainter>
+
+static constexpr int ROW_PADDING = 6;
+static constexpr int COLUMN_SPACING = 12;
+
+TimingView::TimingView(QWidget *parent) : QWidget(parent), total(0) {}
+
+void TimingView::setTimeline(const Session::Timeline &timeline) {
+    using TimePoint = std::optional<std::chrono::steady_clock::time_point>;
+
+    phases.clear();
+    const auto elapsed = [&](const std::chrono::steady_clock::time_point &point) {
+        return std::chrono::duration<double, std::milli>(point - timeline.begin).count();
+    };
+    const auto addPhase = [&](const QString &name, const TimePoint &begin, const TimePoint &end) {
+        if (begin && end) {
+            phases.append({name, elapsed(*begin), elapsed(*end)});
+        }
+    };
+    const auto firstOf = [](std::initializer_list<TimePoint> points) {
+        for (const auto &point : points) {
+            if (point) {
+                return point;
+            }
+        }
+        return TimePoint();
+    };
+
+    const TimePoint begin = timeline.begin;
+    addPhase("Connect", begin, timeline.channelReady);
+    addPhase("Send headers", firstOf({timeline.channelReady, begin}), timeline.callStarted);
+    addPhase("Wait for headers", timeline.callStarted, timeline.initialMetadataReceived);
+    addPhase("First message", timeline.initialMetadataReceived, timeline.firstMessageReceived);
+    if (timeline.firstMessageReceived != timeline.lastMessageReceived) {
+        addPhase("Stream", timeline.firstMessageReceived, timeline.lastMessageReceived);
+    }
+    addPhase("Trailers",
+             firstOf({timeline.lastMessageReceived, timeline.initialMetadataReceived, timeline.callStarted, begin}),
+             timeline.finished);
+    addPhase("Total", begin, timeline.finished);
+
+    total = 0;
+    for (const auto &phase : phases) {
+        total = std::max(total, phase.end);
+    }
+
+    updateGeometry();
+    update();
+}
+
+void TimingView::clear() {
+    phases.clear();
+    total = 0;
+    updateGeometry();
+    update();
+}
+
+QSize TimingView::sizeHint() const {
+    const auto rowHeight = fontMetrics().height() + ROW_PADDING;
+    return QSize(400, rowHeight * std::max(1, phases.size()) + ROW_PADDING);
+}
+
+void TimingView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event)
+
+    if (phases.isEmpty()) {
+        return;
+    }
+
+    QPainter painter(this);
+    const auto metrics = fontMetrics();
+    const auto rowHeight = metrics.height() + ROW_PADDING;
+
+    int labelWidth = 0;
+    int durationWidth = 0;
+    QStringList durations;
+    for (const auto &phase : phases) {
+        labelWidth = std::max(labelWidth, metrics.horizontalAdvance(phase.name));
+        durations << QString("%1 ms").arg(phase.end - phase.begin, 0, 'f', 3);
+        durationWidth = std::max(durationWidth, metrics.horizontalAdvance(durations.last()));
+    }
+
+    const int barLeft = labelWidth + COLUMN_SPACING;
+    const int barWidth = std::max(1, width() - barLeft - durationWidth - COLUMN_SPACING);
+    const auto scale = total > 0 ? barWidth / total : 0;
+
+    for (int i = 0; i < phases.size(); i++) {
+        const auto &phase = phases[i];
+        const int top = ROW_PADDING / 2 + i * rowHeight;
+        const QRect textRect(0, top, width(), rowHeight);
+
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, phase.name);
+        painter.drawText(textRect, Qt::AlignRight | Qt::AlignVCenter, durations[i]);
+
+        const int left = barLeft + static_cast<int>(phase.begin * scale);
+        const int right = barLeft + static_cast<int>(phase.end * scale);
+        painter.fillRect(QRect(left, top + ROW_PADDING / 2, std::max(1, right - left), rowHeight - ROW_PADDING),
+                         palette().color(QPalette::Highlight));
+    }
+}
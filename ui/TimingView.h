@@ -0,0 +1,39 @@
+#ifndef FLORARPC_TIMINGVIEW_H
+#define FLORARPC_TIMINGVIEW_H
+
+#include <QVector>
+#include <QWidget>
+
+#include "entity/Session.h"
+
+/**
+ * 呼び出しの各段階の所要時間をウォーターフォール形式で表示する
+ */
+class TimingView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit TimingView(QWidget *parent = nullptr);
+
+    void setTimeline(const Session::Timeline &timeline);
+
+    void clear();
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Phase {
+        QString name;
+        // 呼び出し開始からの経過時間 (ミリ秒)
+        double begin;
+        double end;
+    };
+
+    QVector<Phase> phases;
+    double total;
+};
+
+#endif  // FLORARPC_TIMINGVIEW_H
@@ -0,0 +1,80 @@
+#include "DiffResponsesTask.h"
+
+#include <QDebug>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace Task {
+    class DiffResponsesWorker : public QObject, public QRunnable {
+        Q_OBJECT
+
+    public:
+        DiffResponsesWorker(std::shared_ptr<Method> method, const grpc::ByteBuffer &left,
+                            const grpc::ByteBuffer &right, ResponseDiff::Options options,
+                            std::shared_ptr<std::atomic<quint64>> generation)
+            : method(std::move(method)),
+              left(left),
+              right(right),
+              options(std::move(options)),
+              generation(std::move(generation)),
+              ownGeneration(this->generation->load()) {}
+
+        void run() override {
+            if (isInterrupted()) {
+                qDebug() << "DiffResponsesWorker interrupted!";
+                return;
+            }
+
+            // 比較結果は文字列で持つので、デコードしたメッセージはここで捨ててよい
+            google::protobuf::Arena arena;
+            const auto leftMessage = method->parseResponse(left, arena);
+            const auto rightMessage = method->parseResponse(right, arena);
+            if (isInterrupted()) {
+                qDebug() << "DiffResponsesWorker interrupted!";
+                return;
+            }
+
+            emit diffed(ResponseDiff::compare(*leftMessage, *rightMessage, options), ownGeneration);
+        }
+
+    signals:
+        void diffed(const std::shared_ptr<const ResponseDiff> &diff, quint64 generation);
+
+    private:
+        const std::shared_ptr<Method> method;
+        const grpc::ByteBuffer left;
+        const grpc::ByteBuffer right;
+        const ResponseDiff::Options options;
+        const std::shared_ptr<std::atomic<quint64>> generation;
+        const quint64 ownGeneration;
+
+        bool isInterrupted() const { return generation->load() != ownGeneration; }
+    };
+}  // namespace Task
+
+Task::DiffResponsesTask::DiffResponsesTask(std::shared_ptr<Method> method, QObject *parent)
+    : QObject(parent), method(std::move(method)), generation(std::make_shared<std::atomic<quint64>>(0)) {
+    qRegisterMetaType<std::shared_ptr<const ResponseDiff>>();
+}
+
+Task::DiffResponsesTask::~DiffResponsesTask() { cancel(); }
+
+void Task::DiffResponsesTask::diffAsync(const grpc::ByteBuffer &left, const grpc::ByteBuffer &right,
+                                        const ResponseDiff::Options &options) {
+    cancel();
+    auto worker = new DiffResponsesWorker(method, left, right, options, generation);
+    connect(worker, &DiffResponsesWorker::diffed, this, &DiffResponsesTask::onWorkerDiffed);
+    QThreadPool::globalInstance()->start(worker);
+}
+
+void Task::DiffResponsesTask::cancel() { generation->fetch_add(1); }
+
+void Task::DiffResponsesTask::onWorkerDiffed(const std::shared_ptr<const ResponseDiff> &diff, quint64 generation) {
+    // 止めた後に届いたものは捨てる
+    if (generation != this->generation->load()) {
+        return;
+    }
+    emit diffed(diff);
+}
+
+#include "DiffResponsesTask.moc"
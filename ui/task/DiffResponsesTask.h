@@ -0,0 +1,48 @@
+#ifndef FLORARPC_DIFFRESPONSESTASK_H
+#define FLORARPC_DIFFRESPONSESTASK_H
+
+#include <grpcpp/support/byte_buffer.h>
+
+#include <QObject>
+#include <atomic>
+#include <memory>
+
+#include "entity/Method.h"
+#include "entity/ResponseDiff.h"
+
+namespace Task {
+    /**
+     * 2つのレスポンスのデコードと比較をスレッドプールで行う
+     * 新しく始めると前の結果は捨てられる
+     */
+    class DiffResponsesTask : public QObject {
+        Q_OBJECT
+
+        Q_DISABLE_COPY(DiffResponsesTask)
+
+    public:
+        explicit DiffResponsesTask(std::shared_ptr<Method> method, QObject *parent = nullptr);
+
+        ~DiffResponsesTask() override;
+
+        void diffAsync(const grpc::ByteBuffer &left, const grpc::ByteBuffer &right,
+                       const ResponseDiff::Options &options);
+
+        void cancel();
+
+    signals:
+        void diffed(const std::shared_ptr<const ResponseDiff> &diff);
+
+    private slots:
+        void onWorkerDiffed(const std::shared_ptr<const ResponseDiff> &diff, quint64 generation);
+
+    private:
+        std::shared_ptr<Method> method;
+        // diffAsyncとcancelで進める。ワーカーは自分の番号と違っていたら止まる
+        std::shared_ptr<std::atomic<quint64>> generation;
+    };
+}  // namespace Task
+
+Q_DECLARE_METATYPE(std::shared_ptr<const ResponseDiff>)
+
+#endif  // FLORARPC_DIFFRESPONSESTASK_H
@@ -0,0 +1,325 @@
+#include "ExportResponsesTask.h"
+
+#include <google/protobuf/util/json_util.h>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <vector>
+
+#include "util/ProtobufField.h"
+
+namespace Task {
+    using google::protobuf::FieldDescriptor;
+    using google::protobuf::Message;
+
+    // 進捗を知らせる間隔。1件ごとに送るとイベントキューが溢れる
+    static constexpr qint64 progressIntervalMs = 100;
+
+    class ExportResponsesWorker : public QObject, public QRunnable {
+        Q_OBJECT
+
+    public:
+        ExportResponsesWorker(std::shared_ptr<Method> method, std::unique_ptr<ResponseStore::Snapshot> snapshot,
+                              const QString &path, ExportResponsesTask::Format format, const QStringList &columns,
+                              std::shared_ptr<std::atomic<bool>> interrupted)
+            : method(std::move(method)),
+              snapshot(std::move(snapshot)),
+              path(path),
+              format(format),
+              columnNames(columns),
+              interrupted(std::move(interrupted)) {}
+
+        void run() override {
+            runInternal();
+            emit finished();
+        }
+
+    signals:
+        void exported(const QString &path, int written, int skipped);
+
+        void failed(const QString &message);
+
+        void onProgress(int done, int total);
+
+        void finished();
+
+    private:
+        // 列ごとの、ルートから辿るフィールド
+        using Column = std::vector<const FieldDescriptor *>;
+
+        const std::shared_ptr<Method> method;
+        const std::unique_ptr<ResponseStore::Snapshot> snapshot;
+        const QString path;
+        const ExportResponsesTask::Format format;
+        const QStringList columnNames;
+        const std::shared_ptr<std::atomic<bool>> interrupted;
+        std::vector<Column> columns;
+
+        void runInternal() {
+            if (format == ExportResponsesTask::Format::CSV && !resolveColumns()) {
+                return;
+            }
+
+            QSaveFile file(path);
+            if (!file.open(QIODevice::WriteOnly)) {
+                emit failed(QString("%1 を開けませんでした: %2").arg(path, file.errorString()));
+                return;
+            }
+
+            std::string out;
+            if (format == ExportResponsesTask::Format::CSV) {
+                for (int i = 0; i < columnNames.size(); i++) {
+                    appendCsvCell(out, columnNames[i].trimmed().toStdString(), i == 0);
+                }
+                out += "\r\n";
+            }
+
+            const int total = snapshot->size();
+            int written = 0;
+            int skipped = 0;
+            google::protobuf::Arena arena;
+            grpc::ByteBuffer buffer;
+            QElapsedTimer progressTimer;
+            progressTimer.start();
+            for (int i = 0; i < total; i++) {
+                if (*interrupted) {
+                    qDebug() << "ExportResponsesWorker interrupted!";
+                    file.cancelWriting();
+                    return;
+                }
+                if (progressTimer.elapsed() >= progressIntervalMs) {
+                    emit onProgress(i, total);
+                    progressTimer.restart();
+                }
+
+                if (!snapshot->read(i, buffer) || !formatMessage(buffer, arena, out)) {
+                    skipped++;
+                } else {
+                    written++;
+                }
+                arena.Reset();
+
+                if (!out.empty()) {
+                    if (file.write(out.data(), static_cast<qint64>(out.size())) != static_cast<qint64>(out.size())) {
+                        emit failed(QString("%1 へ書き込めませんでした: %2").arg(path, file.errorString()));
+                        file.cancelWriting();
+                        return;
+                    }
+                    out.clear();
+                }
+            }
+
+            if (!file.commit()) {
+                emit failed(QString("%1 へ書き込めませんでした: %2").arg(path, file.errorString()));
+                return;
+            }
+            emit exported(path, written, skipped);
+        }
+
+        bool resolveColumns() {
+            const auto root = method->getResponseType();
+            for (const auto &name : columnNames) {
+                Column column;
+                const auto *type = root;
+                for (const auto &part : name.trimmed().split('.')) {
+                    // 1つ前が繰り返しやメッセージ以外なら、その先は辿れない
+                    const FieldDescriptor *field = nullptr;
+                    if (type != nullptr) {
+                        field = ProtobufField::findField(type, part.toStdString());
+                    }
+                    if (field == nullptr) {
+                        emit failed(QString("%1 に %2 というフィールドはありません").arg(
+                            QString::fromStdString(root->full_name()), name.trimmed()));
+                        return false;
+                    }
+                    column.push_back(field);
+                    type = !field->is_repeated() && field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE
+                               ? field->message_type()
+                               : nullptr;
+                }
+                columns.push_back(std::move(column));
+            }
+            return true;
+        }
+
+        bool formatMessage(const grpc::ByteBuffer &buffer, google::protobuf::Arena &arena, std::string &out) {
+            if (format == ExportResponsesTask::Format::Delimited) {
+                return appendDelimited(buffer, out);
+            }
+
+            const auto message = method->parseResponse(buffer, arena);
+            if (format == ExportResponsesTask::Format::NDJSON) {
+                if (!appendJson(*message, out)) {
+                    return false;
+                }
+                out += '\n';
+                return true;
+            }
+
+            for (size_t i = 0; i < columns.size(); i++) {
+                std::string cell;
+                appendColumn(*message, columns[i], cell);
+                appendCsvCell(out, cell, i == 0);
+            }
+            out += "\r\n";
+            return true;
+        }
+
+        static bool appendDelimited(const grpc::ByteBuffer &buffer, std::string &out) {
+            std::vector<grpc::Slice> slices;
+            if (!buffer.Dump(&slices).ok()) {
+                return false;
+            }
+            auto length = static_cast<quint64>(buffer.Length());
+            while (length >= 0x80) {
+                out += static_cast<char>(length | 0x80);
+                length >>= 7;
+            }
+            out += static_cast<char>(length);
+            for (const auto &slice : slices) {
+                out.append(reinterpret_cast<const char *>(slice.begin()), slice.size());
+            }
+            return true;
+        }
+
+        static bool appendJson(const Message &message, std::string &out) {
+            std::string json;
+            google::protobuf::util::JsonOptions opts;
+            opts.always_print_primitive_fields = true;
+            if (!google::protobuf::util::MessageToJsonString(message, &json, opts).ok()) {
+                return false;
+            }
+            out += json;
+            return true;
+        }
+
+        /**
+         * 途中のメッセージが無ければ既定値を書く。繰り返しとメッセージはJSONにする
+         */
+        static void appendColumn(const Message &root, const Column &column, std::string &out) {
+            const Message *message = &root;
+            for (size_t i = 0; i + 1 < column.size(); i++) {
+                message = &message->GetReflection()->GetMessage(*message, column[i]);
+            }
+
+            const auto field = column.back();
+            const auto reflection = message->GetReflection();
+            if (!field->is_repeated()) {
+                if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+                    appendJson(reflection->GetMessage(*message, field), out);
+                } else {
+                    appendScalar(*message, field, -1, false, out);
+                }
+                return;
+            }
+
+            out += '[';
+            const int size = reflection->FieldSize(*message, field);
+            for (int i = 0; i < size; i++) {
+                if (i > 0) {
+                    out += ',';
+                }
+                if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+                    appendJson(reflection->GetRepeatedMessage(*message, field, i), out);
+                } else {
+                    appendScalar(*message, field, i, true, out);
+                }
+            }
+            out += ']';
+        }
+
+        /**
+         * indexが負なら繰り返しでないフィールドを読む。quotedなら文字列をJSONの文字列として書く
+         */
+        static void appendScalar(const Message &message, const FieldDescriptor *field, int index, bool quoted,
+                                 std::string &out) {
+            const auto value = ProtobufField::formatScalar(message, field, index);
+            if (quoted && value.quoted) {
+                appendString(value.text, out);
+            } else {
+                out += value.text;
+            }
+        }
+
+        static void appendString(const std::string &value, std::string &out) {
+            static constexpr char hex[] = "0123456789abcdef";
+            out += '"';
+            for (const char c : value) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += hex[(c >> 4) & 0xf];
+                    out += hex[c & 0xf];
+                } else {
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+
+        static void appendCsvCell(std::string &out, const std::string &value, bool first) {
+            if (!first) {
+                out += ',';
+            }
+            if (value.find_first_of(",\"\r\n") == std::string::npos) {
+                out += value;
+                return;
+            }
+            out += '"';
+            for (const char c : value) {
+                if (c == '"') {
+                    out += '"';
+                }
+                out += c;
+            }
+            out += '"';
+        }
+    };
+}  // namespace Task
+
+Task::ExportResponsesTask::ExportResponsesTask(std::shared_ptr<Method> method, QWidget *parent)
+    : QObject(parent),
+      method(std::move(method)),
+      interrupted(std::make_shared<std::atomic<bool>>(false)) {}
+
+Task::ExportResponsesTask::~ExportResponsesTask() {
+    // 先に閉じられても、ワーカーは自分の持つスナップショットを読み終えるか、ここで止まる
+    *interrupted = true;
+}
+
+void Task::ExportResponsesTask::exportAsync(std::unique_ptr<ResponseStore::Snapshot> snapshot, const QString &path,
+                                            Format format, const QStringList &columns) {
+    const int total = snapshot->size();
+    auto worker = new ExportResponsesWorker(method, std::move(snapshot), path, format, columns, interrupted);
+    connect(worker, &ExportResponsesWorker::exported, this, &ExportResponsesTask::exported);
+    connect(worker, &ExportResponsesWorker::failed, this, &ExportResponsesTask::failed);
+    connect(worker, &ExportResponsesWorker::onProgress, this, &ExportResponsesTask::onProgress);
+    connect(worker, &ExportResponsesWorker::finished, this, &ExportResponsesTask::finished);
+
+    progressDialog = new QProgressDialog("レスポンスを書き出しています...", "キャンセル", 0, total,
+                                         qobject_cast<QWidget *>(parent()),
+                                         Qt::CustomizeWindowHint | Qt::WindowTitleHint | Qt::Sheet);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(progressDialog, &QProgressDialog::canceled, this, &ExportResponsesTask::onCanceled);
+    connect(worker, &ExportResponsesWorker::finished, progressDialog, &QProgressDialog::close);
+
+    progressDialog->show();
+    QThreadPool::globalInstance()->start(worker);
+}
+
+void Task::ExportResponsesTask::onProgress(int done, int total) {
+    if (progressDialog) {
+        progressDialog->setMaximum(total);
+        progressDialog->setValue(done);
+    }
+}
+
+void Task::ExportResponsesTask::onCanceled() { *interrupted = true; }
+
+#include "ExportResponsesTask.moc"
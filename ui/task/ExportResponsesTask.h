@@ -0,0 +1,68 @@
+#ifndef FLORARPC_EXPORTRESPONSESTASK_H
+#define FLORARPC_EXPORTRESPONSESTASK_H
+
+#include <QObject>
+#include <QPointer>
+#include <QProgressDialog>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+#include "entity/Method.h"
+#include "entity/ResponseStore.h"
+
+namespace Task {
+    /**
+     * ストアの中身をワーカースレッドで1件ずつデコードしてファイルへ書き出す
+     * 書き出し中に持つのは1件分だけなので、件数が多くてもメモリは増えない
+     */
+    class ExportResponsesTask : public QObject {
+        Q_OBJECT
+
+        Q_DISABLE_COPY(ExportResponsesTask)
+
+    public:
+        enum class Format {
+            // 1行に1件のJSON
+            NDJSON,
+            // 指定したフィールドだけを列にする
+            CSV,
+            // 長さ (varint) と本体の繰り返し。デコードせずにそのまま書く
+            Delimited,
+        };
+
+        explicit ExportResponsesTask(std::shared_ptr<Method> method, QWidget *parent = nullptr);
+
+        ~ExportResponsesTask() override;
+
+        /**
+         * columnsはCSVの列にするフィールドで、"field.sub_field" のように書く
+         */
+        void exportAsync(std::unique_ptr<ResponseStore::Snapshot> snapshot, const QString &path, Format format,
+                         const QStringList &columns);
+
+    signals:
+        /**
+         * skippedは破棄済みなどで書き出せなかった件数
+         */
+        void exported(const QString &path, int written, int skipped);
+
+        void failed(const QString &message);
+
+        void finished();
+
+    private slots:
+        void onProgress(int done, int total);
+
+        void onCanceled();
+
+    private:
+        std::shared_ptr<Method> method;
+        // 閉じると削除される
+        QPointer<QProgressDialog> progressDialog;
+        // ワーカーと共有する。キャンセルされたらワーカーは書きかけのファイルを捨てて止まる
+        std::shared_ptr<std::atomic<bool>> interrupted;
+    };
+}  // namespace Task
+
+#endif  // FLORARPC_EXPORTRESPONSESTASK_H
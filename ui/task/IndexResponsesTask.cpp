@@ -0,0 +1,57 @@
+#include "IndexResponsesTask.h"
+
+#include "entity/ResponseLog.h"
+
+Task::IndexResponsesTask::IndexResponsesTask(std::shared_ptr<Method> method, QObject *parent)
+    : QObject(parent),
+      method(std::move(method)),
+      index(std::make_shared<ResponseIndex>(this->method->getResponseType())) {
+    pool.setMaxThreadCount(1);
+}
+
+Task::IndexResponsesTask::~IndexResponsesTask() {
+    // 残りは捨てる。処理中のものは次のaddで止まる
+    index->clear();
+    pool.clear();
+    pool.waitForDone();
+}
+
+void Task::IndexResponsesTask::addAsync(int firstIndex, const QVector<grpc::ByteBuffer> &messages) {
+    pool.start([method = method, index = index, epoch = index->getEpoch(), firstIndex, messages]() {
+        google::protobuf::Arena arena;
+        for (int i = 0; i < messages.size(); i++) {
+            const auto message = method->parseResponse(messages[i], arena);
+            if (!index->add(epoch, firstIndex + i, *message)) {
+                return;
+            }
+            arena.Reset();
+        }
+    });
+}
+
+void Task::IndexResponsesTask::addLogAsync(const QString &path) {
+    pool.start([method = method, index = index, epoch = index->getEpoch(), path]() {
+        // GUIスレッドのストアとは別に開いて読む
+        ResponseLog log;
+        if (!log.open(path)) {
+            return;
+        }
+        google::protobuf::Arena arena;
+        grpc::ByteBuffer buffer;
+        for (int i = 0; i < log.size(); i++) {
+            if (!log.read(i, buffer, nullptr)) {
+                continue;
+            }
+            const auto message = method->parseResponse(buffer, arena);
+            if (!index->add(epoch, i, *message)) {
+                return;
+            }
+            arena.Reset();
+        }
+    });
+}
+
+void Task::IndexResponsesTask::clear() {
+    pool.clear();
+    index->clear();
+}
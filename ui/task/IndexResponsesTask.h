@@ -0,0 +1,51 @@
+#ifndef FLORARPC_INDEXRESPONSESTASK_H
+#define FLORARPC_INDEXRESPONSESTASK_H
+
+#include <grpcpp/support/byte_buffer.h>
+
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+
+#include "entity/Method.h"
+#include "entity/ResponseIndex.h"
+
+namespace Task {
+    /**
+     * 受信したレスポンスを、受信順にワーカースレッドでデコードして索引に加える
+     */
+    class IndexResponsesTask : public QObject {
+        Q_DISABLE_COPY(IndexResponsesTask)
+
+    public:
+        explicit IndexResponsesTask(std::shared_ptr<Method> method, QObject *parent = nullptr);
+
+        ~IndexResponsesTask() override;
+
+        /**
+         * firstIndex番目から続くmessagesを索引に加える。ByteBufferはスライスの参照だけを持つ
+         */
+        void addAsync(int firstIndex, const QVector<grpc::ByteBuffer> &messages);
+
+        /**
+         * 保存済みのログの中身を全て索引に加える
+         */
+        void addLogAsync(const QString &path);
+
+        /**
+         * 索引を空にする。処理待ちのものも捨てる
+         */
+        void clear();
+
+        inline std::vector<int> search(const QString &query) const { return index->search(query); }
+
+    private:
+        std::shared_ptr<Method> method;
+        std::shared_ptr<ResponseIndex> index;
+        // 受信順に索引へ入れるよう、1スレッドで順に処理する
+        QThreadPool pool;
+    };
+}  // namespace Task
+
+#endif  // FLORARPC_INDEXRESPONSESTASK_H
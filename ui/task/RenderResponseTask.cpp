@@ -0,0 +1,134 @@
+#include "RenderResponseTask.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+
+namespace Task {
+    // 巨大なレスポンスはエディタが固まるので、表示は先頭だけにする
+    static constexpr int maxDisplayLength = 16 * 1024 * 1024;
+
+    static QThreadPool *renderPool() {
+        static QThreadPool *pool = nullptr;
+        if (pool == nullptr) {
+            pool = new QThreadPool(QCoreApplication::instance());
+            pool->setMaxThreadCount(std::max(2, QThread::idealThreadCount() / 2));
+        }
+        return pool;
+    }
+
+    class RenderResponseWorker : public QObject, public QRunnable {
+        Q_OBJECT
+
+    public:
+        RenderResponseWorker(std::shared_ptr<Method> method, const grpc::ByteBuffer &buffer, const QFont &font,
+                             std::shared_ptr<const ResponseProjection> projection,
+                             std::shared_ptr<std::atomic<quint64>> generation)
+            : method(std::move(method)),
+              buffer(buffer),
+              font(font),
+              projection(std::move(projection)),
+              generation(std::move(generation)),
+              ownGeneration(this->generation->load()) {}
+
+        void run() override {
+            std::shared_ptr<const google::protobuf::Message> message;
+            auto document = render(message);
+            if (!document) {
+                qDebug() << "RenderResponseWorker interrupted!";
+                return;
+            }
+
+            // 受け取り側が先に無くなっても、GUIスレッドで解放されるようにする
+            document->moveToThread(QCoreApplication::instance()->thread());
+            const std::shared_ptr<QTextDocument> shared(document.release(),
+                                                        [](QTextDocument *d) { d->deleteLater(); });
+            emit rendered(shared, message, ownGeneration);
+        }
+
+    signals:
+        void rendered(const std::shared_ptr<QTextDocument> &document,
+                      const std::shared_ptr<const google::protobuf::Message> &message, quint64 generation);
+
+    private:
+        const std::shared_ptr<Method> method;
+        const grpc::ByteBuffer buffer;
+        const QFont font;
+        const std::shared_ptr<const ResponseProjection> projection;
+        const std::shared_ptr<std::atomic<quint64>> generation;
+        const quint64 ownGeneration;
+
+        // メンバーは逆順に破棄されるので、arenaのメッセージが先に無くなる
+        struct Decoded {
+            std::shared_ptr<const ResponseProjection> projection;
+            google::protobuf::Arena arena;
+        };
+
+        bool isInterrupted() const { return generation->load() != ownGeneration; }
+
+        std::unique_ptr<QTextDocument> render(std::shared_ptr<const google::protobuf::Message> &message) {
+            if (isInterrupted()) {
+                return nullptr;
+            }
+
+            // ツリー表示でも使うので、デコードしたメッセージはArenaごと渡す
+            const auto decoded = std::make_shared<Decoded>();
+            decoded->projection = projection;
+            message = std::shared_ptr<const google::protobuf::Message>(
+                decoded, method->parseResponse(buffer, decoded->arena, projection.get()));
+            if (isInterrupted()) {
+                return nullptr;
+            }
+            bool truncated = false;
+            auto text = method->formatResponse(*message, maxDisplayLength, truncated, projection.get());
+            if (truncated) {
+                text += QString::asprintf("\n... (%d文字以降を省略しました)", maxDisplayLength);
+            }
+            if (isInterrupted()) {
+                return nullptr;
+            }
+
+            auto document = std::make_unique<QTextDocument>();
+            document->setUndoRedoEnabled(false);
+            document->setDefaultFont(font);
+            document->setPlainText(text);
+            if (isInterrupted()) {
+                return nullptr;
+            }
+            return document;
+        }
+    };
+}  // namespace Task
+
+Task::RenderResponseTask::RenderResponseTask(std::shared_ptr<Method> method, QObject *parent)
+    : QObject(parent), method(std::move(method)), generation(std::make_shared<std::atomic<quint64>>(0)) {
+    qRegisterMetaType<std::shared_ptr<QTextDocument>>();
+    qRegisterMetaType<std::shared_ptr<const google::protobuf::Message>>();
+}
+
+Task::RenderResponseTask::~RenderResponseTask() { cancel(); }
+
+void Task::RenderResponseTask::renderAsync(const grpc::ByteBuffer &buffer, const QFont &font,
+                                           std::shared_ptr<const ResponseProjection> projection) {
+    cancel();
+    auto worker = new RenderResponseWorker(method, buffer, font, std::move(projection), generation);
+    connect(worker, &RenderResponseWorker::rendered, this, &RenderResponseTask::onWorkerRendered);
+    renderPool()->start(worker);
+}
+
+void Task::RenderResponseTask::cancel() { generation->fetch_add(1); }
+
+void Task::RenderResponseTask::onWorkerRendered(const std::shared_ptr<QTextDocument> &document,
+                                                const std::shared_ptr<const google::protobuf::Message> &message,
+                                                quint64 generation) {
+    // 止めた後に届いたものは捨てる
+    if (generation != this->generation->load()) {
+        return;
+    }
+    emit rendered(document, message);
+}
+
+#include "RenderResponseTask.moc"
@@ -0,0 +1,61 @@
+#ifndef FLORARPC_RENDERRESPONSETASK_H
+#define FLORARPC_RENDERRESPONSETASK_H
+
+#include <grpcpp/support/byte_buffer.h>
+
+#include <QFont>
+#include <QObject>
+#include <QTextDocument>
+#include <atomic>
+#include <memory>
+
+#include "entity/Method.h"
+
+namespace Task {
+    class RenderResponseWorker;
+
+    /**
+     * レスポンスのデコードとJSONへの変換、ドキュメントの構築をスレッドプールで行う
+     * 新しく始めると前のものは途中で止まり、結果は捨てられる
+     */
+    class RenderResponseTask : public QObject {
+        Q_OBJECT
+
+        Q_DISABLE_COPY(RenderResponseTask)
+
+    public:
+        explicit RenderResponseTask(std::shared_ptr<Method> method, QObject *parent = nullptr);
+
+        ~RenderResponseTask() override;
+
+        /**
+         * projectionがあれば、選ばれたフィールドだけをデコードして表示する
+         */
+        void renderAsync(const grpc::ByteBuffer &buffer, const QFont &font,
+                         std::shared_ptr<const ResponseProjection> projection = nullptr);
+
+        void cancel();
+
+    signals:
+        /**
+         * documentはGUIスレッドに移してある。参照が無くなるとdeleteLaterされる
+         * messageはデコードしたレスポンスで、参照が無くなるとArenaごと解放される。射影した型ならその型も一緒に保たれる
+         */
+        void rendered(const std::shared_ptr<QTextDocument> &document,
+                      const std::shared_ptr<const google::protobuf::Message> &message);
+
+    private slots:
+        void onWorkerRendered(const std::shared_ptr<QTextDocument> &document,
+                              const std::shared_ptr<const google::protobuf::Message> &message, quint64 generation);
+
+    private:
+        std::shared_ptr<Method> method;
+        // renderAsyncとcancelで進める。ワーカーは自分の番号と違っていたら止まる
+        std::shared_ptr<std::atomic<quint64>> generation;
+    };
+}  // namespace Task
+
+Q_DECLARE_METATYPE(std::shared_ptr<QTextDocument>)
+Q_DECLARE_METATYPE(std::shared_ptr<const google::protobuf::Message>)
+
+#endif  // FLORARPC_RENDERRESPONSETASK_H
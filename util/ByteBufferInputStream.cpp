@@ -0,0 +1,54 @@
+#include "ByteBufferInputStream.h"
+
+ByteBufferInputStream::ByteBufferInputStream(const grpc::ByteBuffer &buffer) {
+    if (buffer.Valid()) {
+        buffer.Dump(&slices);
+    }
+}
+
+bool ByteBufferInputStream::Next(const void **data, int *size) {
+    if (backUpCount > 0) {
+        const auto &slice = slices[nextSlice - 1];
+        *data = slice.end() - backUpCount;
+        *size = backUpCount;
+        byteCount += backUpCount;
+        backUpCount = 0;
+        return true;
+    }
+
+    while (nextSlice < slices.size()) {
+        const auto &slice = slices[nextSlice++];
+        if (slice.size() == 0) {
+            continue;
+        }
+        *data = slice.begin();
+        *size = static_cast<int>(slice.size());
+        byteCount += *size;
+        return true;
+    }
+    return false;
+}
+
+void ByteBufferInputStream::BackUp(int count) {
+    // 直前のNextで返した範囲の末尾からしか戻せない
+    backUpCount = count;
+    byteCount -= count;
+}
+
+bool ByteBufferInputStream::Skip(int count) {
+    const void *data;
+    int size;
+    while (count > 0) {
+        if (!Next(&data, &size)) {
+            return false;
+        }
+        if (size > count) {
+            BackUp(size - count);
+            return true;
+        }
+        count -= size;
+    }
+    return true;
+}
+
+int64_t ByteBufferInputStream::ByteCount() const { return byteCount; }
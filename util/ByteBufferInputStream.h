@@ -0,0 +1,32 @@
+#ifndef FLORARPC_BYTEBUFFERINPUTSTREAM_H
+#define FLORARPC_BYTEBUFFERINPUTSTREAM_H
+
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <grpcpp/support/byte_buffer.h>
+
+#include <vector>
+
+/**
+ * grpc::ByteBufferのスライスを連結せずにそのまま読むZeroCopyInputStream
+ */
+class ByteBufferInputStream : public google::protobuf::io::ZeroCopyInputStream {
+public:
+    explicit ByteBufferInputStream(const grpc::ByteBuffer &buffer);
+
+    bool Next(const void **data, int *size) override;
+
+    void BackUp(int count) override;
+
+    bool Skip(int count) override;
+
+    int64_t ByteCount() const override;
+
+private:
+    // Dumpはスライスの参照を取るだけで、中身はコピーしない
+    std::vector<grpc::Slice> slices;
+    size_t nextSlice = 0;
+    int backUpCount = 0;
+    int64_t byteCount = 0;
+};
+
+#endif  // FLORARPC_BYTEBUFFERINPUTSTREAM_H
@@ -1,21 +1,32 @@
 #include "GrpcUtility.h"
 
+#include "ByteBufferInputStream.h"
+
 std::unique_ptr<grpc::ByteBuffer> GrpcUtility::serializeMessage(const google::protobuf::Message &message) {
-    std::string buffer;
-    message.SerializeToString(&buffer);
-    auto slice = grpc::Slice(buffer);
+    // 確保したスライスへ直接書き込む。ByteSizeLongでサイズが確定するので、分割したバッファは要らない
+    const auto size = message.ByteSizeLong();
+    grpc::Slice slice(size);
+    message.SerializeWithCachedSizesToArray(const_cast<uint8_t *>(slice.begin()));
     return std::make_unique<grpc::ByteBuffer>(&slice, 1);
 }
 
 bool GrpcUtility::parseMessage(const grpc::ByteBuffer &buffer, google::protobuf::Message &message) {
-    std::vector<grpc::Slice> slices;
-    buffer.Dump(&slices);
-    std::string buf;
-    buf.reserve(buffer.Length());
-    for (const auto &s : slices) {
-        buf.append(reinterpret_cast<const char *>(s.begin()), s.size());
+    ByteBufferInputStream stream(buffer);
+    return message.ParseFromZeroCopyStream(&stream);
+}
+
+void GrpcUtility::moveAppend(QVector<grpc::ByteBuffer> &dest, QVector<grpc::ByteBuffer> &src) {
+    if (dest.isEmpty()) {
+        dest.swap(src);
+        return;
+    }
+
+    dest.reserve(dest.size() + src.size());
+    for (auto &buffer : src) {
+        dest.append(grpc::ByteBuffer());
+        dest.last().Swap(&buffer);
     }
-    return message.ParseFromString(buf);
+    src.clear();
 }
 
 QString GrpcUtility::errorCodeToString(grpc::StatusCode statusCode) {
@@ -4,12 +4,22 @@
 #include <google/protobuf/message.h>
 #include <grpcpp/support/byte_buffer.h>
 #include <QString>
+#include <QVector>
 
 namespace GrpcUtility {
+    /**
+     * ByteBufferのコピーはスライスの参照を共有するだけなので、同じリクエストを何度送る場合もシリアライズは1回でよい
+     */
     std::unique_ptr<grpc::ByteBuffer> serializeMessage(const google::protobuf::Message &message);
 
     bool parseMessage(const grpc::ByteBuffer &buffer, google::protobuf::Message &message);
 
+    /**
+     * srcの中身をdestの末尾へ移す (スライスの参照カウントも増やさない)
+     * srcは空になる
+     */
+    void moveAppend(QVector<grpc::ByteBuffer> &dest, QVector<grpc::ByteBuffer> &src);
+
     QString errorCodeToString(grpc::StatusCode statusCode);
 }
 
@@ -0,0 +1,151 @@
+#include "JsonHighlighter.h"
+
+#include <QEvent>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <algorithm>
+
+// 見えている範囲の前後にも、スクロールで飛び込んでくる分としてハイライトしておくブロック数
+static constexpr int marginBlocks = 50;
+// これより長いブロックは字句解析もレイアウトも重くなるので、ハイライトしない (整形されていないJSONなど)
+static constexpr int maxHighlightBlockLength = 64 * 1024;
+// これより大きな変更は、影響したブロックをその場で塗り直さず、見えている範囲だけを後で処理する
+static constexpr int maxImmediateChange = 16 * 1024;
+
+static bool isNumberChar(QChar c) {
+    return c.isDigit() || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+JsonHighlighter::JsonHighlighter(QTextEdit &textEdit, const Formats &formats)
+    : QObject(&textEdit), textEdit(textEdit), formats(formats), pendingPass(new QTimer(this)) {
+    pendingPass->setSingleShot(true);
+    pendingPass->setInterval(0);
+    connect(pendingPass, &QTimer::timeout, this, &JsonHighlighter::highlightVisibleBlocks);
+    connect(textEdit.verticalScrollBar(), &QScrollBar::valueChanged, this, &JsonHighlighter::highlightVisibleBlocks);
+    textEdit.viewport()->installEventFilter(this);
+
+    documentReplaced();
+}
+
+void JsonHighlighter::documentReplaced() {
+    disconnect(contentsChangeConnection);
+    document = textEdit.document();
+    contentsChangeConnection =
+        connect(document, &QTextDocument::contentsChange, this, &JsonHighlighter::onContentsChange);
+
+    // 別のドキュメントで付けた印が残っていても、処理済みと見なさないようにする
+    generation++;
+    pendingPass->start();
+}
+
+bool JsonHighlighter::eventFilter(QObject *watched, QEvent *event) {
+    if (event->type() == QEvent::Resize) {
+        pendingPass->start();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void JsonHighlighter::onContentsChange(int from, int charsRemoved, int charsAdded) {
+    if (applying) {
+        return;
+    }
+
+    if (charsRemoved + charsAdded > maxImmediateChange) {
+        generation++;
+        pendingPass->start();
+        return;
+    }
+
+    // 入力中の行は、再描画より前に塗り直す
+    const auto last = document->findBlock(from + charsAdded);
+    for (auto block = document->findBlock(from); block.isValid(); block = block.next()) {
+        highlightBlock(block);
+        if (block == last) {
+            break;
+        }
+    }
+}
+
+void JsonHighlighter::highlightVisibleBlocks() {
+    if (!document || document != textEdit.document()) {
+        return;
+    }
+
+    auto first = textEdit.cursorForPosition(QPoint(0, 0)).block();
+    auto last = textEdit.cursorForPosition(QPoint(0, textEdit.viewport()->height())).block();
+    for (int i = 0; i < marginBlocks && first.previous().isValid(); i++) {
+        first = first.previous();
+    }
+    for (int i = 0; i < marginBlocks && last.next().isValid(); i++) {
+        last = last.next();
+    }
+
+    for (auto block = first; block.isValid(); block = block.next()) {
+        if (block.userState() != generation) {
+            highlightBlock(block);
+        }
+        if (block == last) {
+            break;
+        }
+    }
+}
+
+void JsonHighlighter::highlightBlock(QTextBlock block) {
+    const auto text = block.text();
+    applying = true;
+    block.layout()->setFormats(text.size() <= maxHighlightBlockLength ? lex(text)
+                                                                      : QVector<QTextLayout::FormatRange>());
+    document->markContentsDirty(block.position(), block.length());
+    applying = false;
+    block.setUserState(generation);
+}
+
+QVector<QTextLayout::FormatRange> JsonHighlighter::lex(const QString &text) const {
+    QVector<QTextLayout::FormatRange> ranges;
+    const int length = text.size();
+    int i = 0;
+    while (i < length) {
+        const auto c = text[i];
+        const int start = i;
+
+        if (c.isSpace() || c == '{' || c == '}' || c == '[' || c == ']' || c == ',' || c == ':') {
+            i++;
+            continue;
+        }
+
+        if (c == '"') {
+            for (i++; i < length && text[i] != '"'; i++) {
+                if (text[i] == '\\') {
+                    i++;
+                }
+            }
+            i = std::min(i + 1, length);
+
+            // 直後に:が続けばキー
+            int next = i;
+            while (next < length && text[next].isSpace()) {
+                next++;
+            }
+            const auto &format = (next < length && text[next] == ':') ? formats.key : formats.string;
+            ranges.append({start, i - start, format});
+        } else if (c == '-' || c.isDigit()) {
+            while (i < length && isNumberChar(text[i])) {
+                i++;
+            }
+            ranges.append({start, i - start, formats.number});
+        } else if (c.isLetter()) {
+            while (i < length && text[i].isLetter()) {
+                i++;
+            }
+            const auto word = text.midRef(start, i - start);
+            const bool keyword = word == QLatin1String("true") || word == QLatin1String("false") ||
+                                 word == QLatin1String("null");
+            ranges.append({start, i - start, keyword ? formats.keyword : formats.error});
+        } else {
+            i++;
+            ranges.append({start, 1, formats.error});
+        }
+    }
+    return ranges;
+}
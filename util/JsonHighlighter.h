@@ -0,0 +1,57 @@
+#ifndef FLORARPC_JSONHIGHLIGHTER_H
+#define FLORARPC_JSONHIGHLIGHTER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTextCharFormat>
+#include <QTextEdit>
+#include <QTextLayout>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * QTextEditのうち、見えているブロックと前後の余白だけにJSONのハイライトを付ける
+ * JSONの文字列は改行を含まないので、ブロックごとに独立して字句解析できる
+ * 長すぎるブロックはハイライトせず、そのまま表示する
+ */
+class JsonHighlighter : public QObject {
+public:
+    struct Formats {
+        QTextCharFormat key;
+        QTextCharFormat string;
+        QTextCharFormat number;
+        QTextCharFormat keyword;
+        QTextCharFormat error;
+    };
+
+    JsonHighlighter(QTextEdit &textEdit, const Formats &formats);
+
+    /**
+     * QTextEdit::setDocumentで差し替えた後に呼ぶ
+     */
+    void documentReplaced();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QTextEdit &textEdit;
+    const Formats formats;
+    QPointer<QTextDocument> document;
+    QMetaObject::Connection contentsChangeConnection;
+    QTimer *pendingPass;
+    // ハイライト済みのブロックはuserStateにこの値を持つ。まとめて書き換わった時は進めて、全てを未処理に戻す
+    int generation = 0;
+    // 自分で付けたフォーマットによるcontentsChangeを無視する
+    bool applying = false;
+
+    void onContentsChange(int from, int charsRemoved, int charsAdded);
+
+    void highlightVisibleBlocks();
+
+    void highlightBlock(QTextBlock block);
+
+    QVector<QTextLayout::FormatRange> lex(const QString &text) const;
+};
+
+#endif  // FLORARPC_JSONHIGHLIGHTER_H
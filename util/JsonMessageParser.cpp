@@ -0,0 +1,908 @@
+#include "JsonMessageParser.h"
+
+#include <QByteArray>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+using google::protobuf::Descriptor;
+using google::protobuf::EnumDescriptor;
+using google::protobuf::EnumValueDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+
+// JsonStringToMessageの再帰の上限 (100) より浅くしておく
+static constexpr int maxDepth = 64;
+
+static bool isWellKnownType(const Descriptor *descriptor) { return descriptor->file()->package() == "google.protobuf"; }
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+/**
+ * -?(0|[1-9][0-9]*) の形式だけを受け付ける。範囲外や符号の合わないものはfalse
+ */
+template <typename T>
+static bool parseIntegerText(std::string_view text, T &out) {
+    size_t i = 0;
+    const bool negative = i < text.size() && text[i] == '-';
+    if (negative) {
+        i++;
+    }
+    if (i >= text.size() || (text[i] == '0' && i + 1 != text.size())) {
+        return false;
+    }
+
+    uint64_t magnitude = 0;
+    for (; i < text.size(); i++) {
+        if (!isDigit(text[i])) {
+            return false;
+        }
+        const uint64_t digit = text[i] - '0';
+        if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            return false;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+
+    if (negative) {
+        // 符号なしの "-0" は汎用のパーサーでの扱いが文字列かどうかで変わるので、任せる
+        if (!std::numeric_limits<T>::is_signed ||
+            magnitude > static_cast<uint64_t>(std::numeric_limits<T>::max()) + 1) {
+            return false;
+        }
+        out = magnitude == 0 ? 0 : static_cast<T>(-static_cast<T>(magnitude - 1) - 1);
+    } else {
+        if (magnitude > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+            return false;
+        }
+        out = static_cast<T>(magnitude);
+    }
+    return true;
+}
+
+static int base64Value(char c, bool webSafe) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    } else if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    } else if (isDigit(c)) {
+        return c - '0' + 52;
+    } else if (c == (webSafe ? '-' : '+')) {
+        return 62;
+    } else if (c == (webSafe ? '_' : '/')) {
+        return 63;
+    }
+    return -1;
+}
+
+/**
+ * 標準とURLセーフのどちらのアルファベットも受け付ける。パディングは省略可
+ */
+static bool decodeBase64(std::string_view text, std::string &out) {
+    const bool webSafe = text.find_first_of("-_") != std::string_view::npos;
+
+    size_t padding = 0;
+    while (!text.empty() && text.back() == '=') {
+        text.remove_suffix(1);
+        padding++;
+    }
+    if (padding > 2 || (padding > 0 && (text.size() + padding) % 4 != 0) || text.size() % 4 == 1) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(text.size() / 4 * 3 + 2);
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (const char c : text) {
+        const int value = base64Value(c, webSafe);
+        if (value < 0) {
+            return false;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            out.push_back(static_cast<char>((bits >> bitCount) & 0xff));
+        }
+    }
+    // 使われない下位ビットが立っている入力は、デコーダによって扱いが違うので任せる
+    return (bits & ((1u << bitCount) - 1)) == 0;
+}
+
+static void appendUtf8(std::string &out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    } else if (codePoint < 0x10000) {
+        out.push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    } else {
+        out.push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    }
+}
+
+/**
+ * 正しいUTF-8のシーケンスならそのバイト数、そうでなければ0を返す
+ */
+static size_t utf8SequenceLength(const char *p, const char *end) {
+    const auto lead = static_cast<unsigned char>(*p);
+    size_t length;
+    uint32_t codePoint;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+        codePoint = lead & 0x1f;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        codePoint = lead & 0x0f;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        codePoint = lead & 0x07;
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(end - p) < length) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+        const auto trail = static_cast<unsigned char>(p[i]);
+        if ((trail & 0xc0) != 0x80) {
+            return 0;
+        }
+        codePoint = (codePoint << 6) | (trail & 0x3f);
+    }
+    // 冗長な表現、サロゲート、範囲外
+    if ((length == 3 && codePoint < 0x800) || (length == 4 && codePoint < 0x10000) ||
+        (codePoint >= 0xd800 && codePoint <= 0xdfff) || codePoint > 0x10ffff) {
+        return 0;
+    }
+    return length;
+}
+
+class JsonMessageParser::Reader {
+public:
+    Reader(const JsonMessageParser &parser, const std::string &json)
+        : parser(parser), p(json.data()), end(json.data() + json.size()) {}
+
+    bool readDocument(Message &message) {
+        skipWhitespace();
+        if (!readMessage(message, 0)) {
+            return false;
+        }
+        skipWhitespace();
+        return p == end;
+    }
+
+private:
+    const JsonMessageParser &parser;
+    const char *p;
+    const char *end;
+    std::string keyBuffer;
+
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+            p++;
+        }
+    }
+
+    bool consume(char c) {
+        if (p < end && *p == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeLiteral(std::string_view literal) {
+        if (static_cast<size_t>(end - p) < literal.size() || std::string_view(p, literal.size()) != literal) {
+            return false;
+        }
+        p += literal.size();
+        return true;
+    }
+
+    bool peek(char c) const { return p < end && *p == c; }
+
+    bool readMessage(Message &message, int depth) {
+        const auto plan = parser.findPlan(message.GetDescriptor());
+        if (plan == nullptr || depth > maxDepth || !consume('{')) {
+            return false;
+        }
+        const auto reflection = message.GetReflection();
+
+        std::vector<const FieldDescriptor *> seen;
+        skipWhitespace();
+        if (consume('}')) {
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            std::string_view key;
+            if (!readKey(key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (!consume(':')) {
+                return false;
+            }
+            skipWhitespace();
+
+            const auto found = plan->fields.find(key);
+            if (found == plan->fields.end()) {
+                // "[package.extension]"
+                if (!key.empty() && key.front() == '[') {
+                    return false;
+                }
+                if (!skipValue(depth + 1)) {
+                    return false;
+                }
+            } else {
+                // 同じフィールドやoneofの重複は、汎用のパーサーにエラーを出させる
+                const auto field = found->second;
+                const auto oneof = field->real_containing_oneof();
+                for (const auto other : seen) {
+                    if (other == field || (oneof != nullptr && other->real_containing_oneof() == oneof)) {
+                        return false;
+                    }
+                }
+                seen.push_back(field);
+
+                if (!readField(message, *reflection, field, depth + 1)) {
+                    return false;
+                }
+            }
+
+            skipWhitespace();
+            if (!consume(',')) {
+                return consume('}');
+            }
+        }
+    }
+
+    bool readField(Message &message, const Reflection &reflection, const FieldDescriptor *field, int depth) {
+        if (peek('n')) {
+            // nullは未設定として扱われる。repeatedやmap、oneofでの扱いは汎用のパーサーに任せる
+            if (field->is_repeated() || field->real_containing_oneof() != nullptr ||
+                (field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM &&
+                 field->enum_type()->full_name() == "google.protobuf.NullValue") ||
+                (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE && isWellKnownType(field->message_type()))) {
+                return false;
+            }
+            return consumeLiteral("null");
+        }
+
+        if (field->is_map()) {
+            return readMap(message, reflection, field, depth);
+        }
+
+        if (field->is_repeated()) {
+            if (!consume('[')) {
+                return false;
+            }
+            skipWhitespace();
+            if (consume(']')) {
+                return true;
+            }
+            while (true) {
+                skipWhitespace();
+                if (!readValue(message, reflection, field, depth)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (!consume(',')) {
+                    return consume(']');
+                }
+            }
+        }
+
+        return readValue(message, reflection, field, depth);
+    }
+
+    bool readMap(Message &message, const Reflection &reflection, const FieldDescriptor *field, int depth) {
+        const auto keyField = field->message_type()->map_key();
+        const auto valueField = field->message_type()->map_value();
+        if (!consume('{')) {
+            return false;
+        }
+        skipWhitespace();
+        if (consume('}')) {
+            return true;
+        }
+
+        std::unordered_set<std::string> keys;
+        std::string key;
+        while (true) {
+            skipWhitespace();
+            if (!readString(key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (!consume(':')) {
+                return false;
+            }
+            skipWhitespace();
+            if (peek('n') || !keys.insert(key).second) {
+                return false;
+            }
+
+            const auto entry = reflection.AddMessage(&message, field);
+            const auto entryReflection = entry->GetReflection();
+            if (!setMapKey(*entry, *entryReflection, keyField, key) ||
+                !readValue(*entry, *entryReflection, valueField, depth)) {
+                return false;
+            }
+
+            skipWhitespace();
+            if (!consume(',')) {
+                return consume('}');
+            }
+        }
+    }
+
+    static bool setMapKey(Message &entry, const Reflection &reflection, const FieldDescriptor *field,
+                          const std::string &key) {
+        switch (field->cpp_type()) {
+            case FieldDescriptor::CPPTYPE_INT32: {
+                int32_t value;
+                if (!parseIntegerText(key, value)) {
+                    return false;
+                }
+                reflection.SetInt32(&entry, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_INT64: {
+                int64_t value;
+                if (!parseIntegerText(key, value)) {
+                    return false;
+                }
+                reflection.SetInt64(&entry, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_UINT32: {
+                uint32_t value;
+                if (!parseIntegerText(key, value)) {
+                    return false;
+                }
+                reflection.SetUInt32(&entry, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_UINT64: {
+                uint64_t value;
+                if (!parseIntegerText(key, value)) {
+                    return false;
+                }
+                reflection.SetUInt64(&entry, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_BOOL:
+                if (key != "true" && key != "false") {
+                    return false;
+                }
+                reflection.SetBool(&entry, field, key == "true");
+                return true;
+            case FieldDescriptor::CPPTYPE_STRING:
+                reflection.SetString(&entry, field, key);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool readValue(Message &message, const Reflection &reflection, const FieldDescriptor *field, int depth) {
+        const bool repeated = field->is_repeated();
+        switch (field->cpp_type()) {
+            case FieldDescriptor::CPPTYPE_INT32: {
+                int32_t value;
+                if (!readInteger(value)) {
+                    return false;
+                }
+                repeated ? reflection.AddInt32(&message, field, value) : reflection.SetInt32(&message, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_INT64: {
+                int64_t value;
+                if (!readInteger(value)) {
+                    return false;
+                }
+                repeated ? reflection.AddInt64(&message, field, value) : reflection.SetInt64(&message, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_UINT32: {
+                uint32_t value;
+                if (!readInteger(value)) {
+                    return false;
+                }
+                repeated ? reflection.AddUInt32(&message, field, value)
+                         : reflection.SetUInt32(&message, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_UINT64: {
+                uint64_t value;
+                if (!readInteger(value)) {
+                    return false;
+                }
+                repeated ? reflection.AddUInt64(&message, field, value)
+                         : reflection.SetUInt64(&message, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_DOUBLE: {
+                double value;
+                if (!readFloating(value, false)) {
+                    return false;
+                }
+                repeated ? reflection.AddDouble(&message, field, value)
+                         : reflection.SetDouble(&message, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_FLOAT: {
+                double value;
+                if (!readFloating(value, true)) {
+                    return false;
+                }
+                const auto floatValue = static_cast<float>(value);
+                repeated ? reflection.AddFloat(&message, field, floatValue)
+                         : reflection.SetFloat(&message, field, floatValue);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_BOOL: {
+                bool value;
+                if (consumeLiteral("true")) {
+                    value = true;
+                } else if (consumeLiteral("false")) {
+                    value = false;
+                } else {
+                    return false;
+                }
+                repeated ? reflection.AddBool(&message, field, value) : reflection.SetBool(&message, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_ENUM: {
+                int value;
+                if (!readEnum(field->enum_type(), value)) {
+                    return false;
+                }
+                repeated ? reflection.AddEnumValue(&message, field, value)
+                         : reflection.SetEnumValue(&message, field, value);
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_STRING: {
+                std::string value;
+                if (!readString(value)) {
+                    return false;
+                }
+                if (field->type() == FieldDescriptor::TYPE_BYTES) {
+                    std::string decoded;
+                    if (!decodeBase64(value, decoded)) {
+                        return false;
+                    }
+                    value.swap(decoded);
+                }
+                repeated ? reflection.AddString(&message, field, std::move(value))
+                         : reflection.SetString(&message, field, std::move(value));
+                return true;
+            }
+            case FieldDescriptor::CPPTYPE_MESSAGE: {
+                if (field->type() == FieldDescriptor::TYPE_GROUP) {
+                    return false;
+                }
+                const auto child =
+                    repeated ? reflection.AddMessage(&message, field) : reflection.MutableMessage(&message, field);
+                return readMessage(*child, depth);
+            }
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool readInteger(T &out) {
+        std::string_view text;
+        if (peek('"')) {
+            // 64bit整数は文字列で書かれることが多い
+            if (!readRawString(text)) {
+                return false;
+            }
+        } else {
+            bool integral;
+            if (!readNumberToken(text, integral) || !integral) {
+                return false;
+            }
+        }
+        return parseIntegerText(text, out);
+    }
+
+    bool readFloating(double &out, bool isFloat) {
+        if (peek('"')) {
+            std::string_view text;
+            if (!readRawString(text)) {
+                return false;
+            }
+            if (text == "NaN") {
+                out = std::numeric_limits<double>::quiet_NaN();
+            } else if (text == "Infinity") {
+                out = std::numeric_limits<double>::infinity();
+            } else if (text == "-Infinity") {
+                out = -std::numeric_limits<double>::infinity();
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        std::string_view text;
+        bool integral;
+        if (!readNumberToken(text, integral)) {
+            return false;
+        }
+        if (integral) {
+            // 2^53までなら整数のまま変換しても丸めが起きない
+            int64_t value;
+            if (!parseIntegerText(text, value) || value > (int64_t(1) << 53) || value < -(int64_t(1) << 53)) {
+                return false;
+            }
+            out = static_cast<double>(value);
+            return true;
+        }
+
+        bool ok;
+        out = QByteArray::fromRawData(text.data(), static_cast<int>(text.size())).toDouble(&ok);
+        if (!ok || !std::isfinite(out)) {
+            return false;
+        }
+        return !isFloat || std::fabs(out) <= std::numeric_limits<float>::max();
+    }
+
+    bool readEnum(const EnumDescriptor *type, int &out) {
+        const EnumValueDescriptor *value = nullptr;
+        if (peek('"')) {
+            std::string name;
+            if (!readString(name)) {
+                return false;
+            }
+            value = type->FindValueByName(name);
+            if (value == nullptr) {
+                int32_t number;
+                if (parseIntegerText(name, number)) {
+                    value = type->FindValueByNumber(number);
+                }
+            }
+            if (value == nullptr) {
+                // case_insensitive_enum_parsing
+                for (auto &c : name) {
+                    c = c == '-' ? '_' : (c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c);
+                }
+                value = type->FindValueByName(name);
+            }
+        } else {
+            std::string_view text;
+            bool integral;
+            int32_t number;
+            if (!readNumberToken(text, integral) || !integral || !parseIntegerText(text, number)) {
+                return false;
+            }
+            value = type->FindValueByNumber(number);
+        }
+
+        // 未定義の値は無視するかどうかが構文によって変わるので、汎用のパーサーに任せる
+        if (value == nullptr) {
+            return false;
+        }
+        out = value->number();
+        return true;
+    }
+
+    bool readNumberToken(std::string_view &token, bool &integral) {
+        const char *begin = p;
+        consume('-');
+        if (p >= end) {
+            return false;
+        }
+        if (*p == '0') {
+            p++;
+        } else if (isDigit(*p)) {
+            while (p < end && isDigit(*p)) {
+                p++;
+            }
+        } else {
+            return false;
+        }
+
+        integral = true;
+        if (consume('.')) {
+            integral = false;
+            if (p >= end || !isDigit(*p)) {
+                return false;
+            }
+            while (p < end && isDigit(*p)) {
+                p++;
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            integral = false;
+            p++;
+            if (p < end && (*p == '+' || *p == '-')) {
+                p++;
+            }
+            if (p >= end || !isDigit(*p)) {
+                return false;
+            }
+            while (p < end && isDigit(*p)) {
+                p++;
+            }
+        }
+
+        token = std::string_view(begin, p - begin);
+        return true;
+    }
+
+    /**
+     * エスケープを含まないASCII文字列を、入力を指したまま読む
+     */
+    bool readRawString(std::string_view &out) {
+        if (!consume('"')) {
+            return false;
+        }
+        const char *begin = p;
+        while (p < end) {
+            const auto c = static_cast<unsigned char>(*p);
+            if (c == '"') {
+                out = std::string_view(begin, p - begin);
+                p++;
+                return true;
+            }
+            if (c == '\\' || c < 0x20 || c >= 0x80) {
+                return false;
+            }
+            p++;
+        }
+        return false;
+    }
+
+    bool readKey(std::string_view &key) {
+        const char *begin = p;
+        if (readRawString(key)) {
+            return true;
+        }
+        p = begin;
+        if (!readString(keyBuffer)) {
+            return false;
+        }
+        key = keyBuffer;
+        return true;
+    }
+
+    bool readString(std::string &out) {
+        if (!consume('"')) {
+            return false;
+        }
+        out.clear();
+        while (p < end) {
+            const char *run = p;
+            while (p < end) {
+                const auto c = static_cast<unsigned char>(*p);
+                if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) {
+                    break;
+                }
+                p++;
+            }
+            out.append(run, p - run);
+            if (p >= end) {
+                return false;
+            }
+
+            const auto c = static_cast<unsigned char>(*p);
+            if (c == '"') {
+                p++;
+                return true;
+            } else if (c == '\\') {
+                p++;
+                if (!readEscape(out)) {
+                    return false;
+                }
+            } else if (c >= 0x80) {
+                const auto length = utf8SequenceLength(p, end);
+                if (length == 0) {
+                    return false;
+                }
+                out.append(p, length);
+                p += length;
+            } else {
+                // 制御文字はエスケープが必要
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool readEscape(std::string &out) {
+        if (p >= end) {
+            return false;
+        }
+        switch (*p++) {
+            case '"':
+                out.push_back('"');
+                return true;
+            case '\\':
+                out.push_back('\\');
+                return true;
+            case '/':
+                out.push_back('/');
+                return true;
+            case 'b':
+                out.push_back('\b');
+                return true;
+            case 'f':
+                out.push_back('\f');
+                return true;
+            case 'n':
+                out.push_back('\n');
+                return true;
+            case 'r':
+                out.push_back('\r');
+                return true;
+            case 't':
+                out.push_back('\t');
+                return true;
+            case 'u': {
+                uint32_t codePoint;
+                if (!readHex4(codePoint) || (codePoint >= 0xdc00 && codePoint <= 0xdfff)) {
+                    return false;
+                }
+                if (codePoint >= 0xd800 && codePoint <= 0xdbff) {
+                    uint32_t low;
+                    if (!consume('\\') || !consume('u') || !readHex4(low) || low < 0xdc00 || low > 0xdfff) {
+                        return false;
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                }
+                appendUtf8(out, codePoint);
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    bool readHex4(uint32_t &out) {
+        if (end - p < 4) {
+            return false;
+        }
+        out = 0;
+        for (int i = 0; i < 4; i++) {
+            const char c = *p++;
+            out <<= 4;
+            if (isDigit(c)) {
+                out |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                out |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                out |= c - 'A' + 10;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool skipValue(int depth) {
+        if (depth > maxDepth || p >= end) {
+            return false;
+        }
+        switch (*p) {
+            case '{': {
+                p++;
+                skipWhitespace();
+                if (consume('}')) {
+                    return true;
+                }
+                while (true) {
+                    skipWhitespace();
+                    std::string_view key;
+                    if (!readKey(key)) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (!consume(':')) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (!skipValue(depth + 1)) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (!consume(',')) {
+                        return consume('}');
+                    }
+                }
+            }
+            case '[': {
+                p++;
+                skipWhitespace();
+                if (consume(']')) {
+                    return true;
+                }
+                while (true) {
+                    skipWhitespace();
+                    if (!skipValue(depth + 1)) {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (!consume(',')) {
+                        return consume(']');
+                    }
+                }
+            }
+            case '"': {
+                std::string value;
+                return readString(value);
+            }
+            case 't':
+                return consumeLiteral("true");
+            case 'f':
+                return consumeLiteral("false");
+            case 'n':
+                return consumeLiteral("null");
+            default: {
+                std::string_view token;
+                bool integral;
+                if (!readNumberToken(token, integral)) {
+                    return false;
+                }
+                // 読み飛ばす値でも、doubleに収まらない数はJsonStringToMessageがエラーにする
+                bool ok;
+                const auto value = QByteArray::fromRawData(token.data(), static_cast<int>(token.size())).toDouble(&ok);
+                return ok && std::isfinite(value);
+            }
+        }
+    }
+};
+
+JsonMessageParser::JsonMessageParser(const Descriptor *descriptor) : descriptor(descriptor) { compile(descriptor); }
+
+bool JsonMessageParser::parse(const std::string &json, Message &message) const {
+    if (message.GetDescriptor() != descriptor) {
+        return false;
+    }
+    Reader reader(*this, json);
+    return reader.readDocument(message);
+}
+
+void JsonMessageParser::compile(const Descriptor *message) {
+    // well-known typeは独自のJSON表現を持ち、proto2はrequiredの検査や未定義のenumの扱いが違うので、
+    // 表を作らずに汎用のパーサーへ回す
+    if (plans.count(message) > 0 || isWellKnownType(message) ||
+        message->file()->syntax() != FileDescriptor::SYNTAX_PROTO3) {
+        return;
+    }
+
+    auto &plan = plans[message];
+    for (int i = 0; i < message->field_count(); i++) {
+        const auto field = message->field(i);
+        plan.fields.emplace(field->name(), field);
+    }
+    // 名前が衝突した場合はjson_nameを優先する
+    for (int i = 0; i < message->field_count(); i++) {
+        const auto field = message->field(i);
+        plan.fields[field->json_name()] = field;
+    }
+
+    for (int i = 0; i < message->field_count(); i++) {
+        if (const auto child = message->field(i)->message_type()) {
+            compile(child);
+        }
+    }
+}
+
+const JsonMessageParser::MessagePlan *JsonMessageParser::findPlan(const Descriptor *message) const {
+    const auto found = plans.find(message);
+    return found != plans.end() ? &found->second : nullptr;
+}
@@ -0,0 +1,41 @@
+#ifndef FLORARPC_JSONMESSAGEPARSER_H
+#define FLORARPC_JSONMESSAGEPARSER_H
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * Descriptorごとにフィールド名の表を事前に組み立てておくJSONパーサー
+ * JsonStringToMessage (ignore_unknown_fields, case_insensitive_enum_parsing) と同じ結果になる範囲だけを扱う
+ */
+class JsonMessageParser {
+public:
+    explicit JsonMessageParser(const google::protobuf::Descriptor *descriptor);
+
+    /**
+     * well-known typeやproto2の型、解釈に揺れのある値、不正なJSONなど、扱えない入力ではfalseを返す
+     * その場合messageは書きかけなので、Clearしてから汎用のパーサーで読み直すこと
+     */
+    bool parse(const std::string &json, google::protobuf::Message &message) const;
+
+private:
+    class Reader;
+
+    struct MessagePlan {
+        // json_nameと元のフィールド名の両方で引ける。キーはDescriptorが持つ文字列を指す
+        std::unordered_map<std::string_view, const google::protobuf::FieldDescriptor *> fields;
+    };
+
+    const google::protobuf::Descriptor *descriptor;
+    std::unordered_map<const google::protobuf::Descriptor *, MessagePlan> plans;
+
+    void compile(const google::protobuf::Descriptor *message);
+
+    const MessagePlan *findPlan(const google::protobuf::Descriptor *message) const;
+};
+
+#endif  // FLORARPC_JSONMESSAGEPARSER_H
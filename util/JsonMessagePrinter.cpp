@@ -0,0 +1,591 @@
+#include "JsonMessagePrinter.h"
+
+#include <QByteArray>
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using google::protobuf::Descriptor;
+using google::protobuf::EnumDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+
+static bool isWellKnownType(const Descriptor *descriptor) { return descriptor->file()->package() == "google.protobuf"; }
+
+/**
+ * 次のコードポイントを読んでバイト数を返す。不正なUTF-8なら0
+ */
+static size_t decodeUtf8(const char *p, const char *end, uint32_t &codePoint) {
+    const auto lead = static_cast<unsigned char>(*p);
+    size_t length;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+        codePoint = lead & 0x1f;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        codePoint = lead & 0x0f;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        codePoint = lead & 0x07;
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(end - p) < length) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+        const auto trail = static_cast<unsigned char>(p[i]);
+        if ((trail & 0xc0) != 0x80) {
+            return 0;
+        }
+        codePoint = (codePoint << 6) | (trail & 0x3f);
+    }
+    if ((length == 3 && codePoint < 0x800) || (length == 4 && codePoint < 0x10000) ||
+        (codePoint >= 0xd800 && codePoint <= 0xdfff) || codePoint > 0x10ffff) {
+        return 0;
+    }
+    return length;
+}
+
+/**
+ * protobufのJSON出力がエスケープする非ASCIIの文字 (C1制御文字とUnicodeの書式文字)
+ */
+static bool needsEscape(uint32_t codePoint) {
+    return codePoint <= 0x9f || codePoint == 0xad || (codePoint >= 0x600 && codePoint <= 0x603) ||
+           codePoint == 0x6dd || codePoint == 0x70f || (codePoint >= 0x17b4 && codePoint <= 0x17b5) ||
+           (codePoint >= 0x200b && codePoint <= 0x200f) || (codePoint >= 0x2028 && codePoint <= 0x202e) ||
+           (codePoint >= 0x2060 && codePoint <= 0x2064) || (codePoint >= 0x206a && codePoint <= 0x206f) ||
+           codePoint == 0xfeff || (codePoint >= 0xfff9 && codePoint <= 0xfffb) ||
+           (codePoint >= 0x1d173 && codePoint <= 0x1d17a) || codePoint == 0xe0001 ||
+           (codePoint >= 0xe0020 && codePoint <= 0xe007f);
+}
+
+static bool isPlainAscii(char c) { return c >= 0x20 && c < 0x7f && c != '"' && c != '\\' && c != '<' && c != '>'; }
+
+static bool isFloatChar(char c) { return (c >= '0' && c <= '9') || c == 'e' || c == 'E' || c == '+' || c == '-'; }
+
+/**
+ * snprintfがロケールの小数点を使った場合に '.' へ置き換える (protobufのDelocalizeRadixと同じ)
+ */
+static void delocalizeRadix(char *buffer) {
+    if (std::strchr(buffer, '.') != nullptr) {
+        return;
+    }
+    while (isFloatChar(*buffer)) {
+        buffer++;
+    }
+    if (*buffer == '\0') {
+        return;
+    }
+    *buffer++ = '.';
+    if (!isFloatChar(*buffer) && *buffer != '\0') {
+        char *target = buffer;
+        do {
+            buffer++;
+        } while (!isFloatChar(*buffer) && *buffer != '\0');
+        std::memmove(target, buffer, std::strlen(buffer) + 1);
+    }
+}
+
+static double parseDouble(const char *buffer) {
+    return QByteArray::fromRawData(buffer, static_cast<int>(std::strlen(buffer))).toDouble();
+}
+
+class JsonMessagePrinter::Writer {
+public:
+    Writer(const JsonMessagePrinter &printer, QString &out, int maxLength)
+        : printer(printer), out(out), maxLength(maxLength) {}
+
+    inline bool isTruncated() const { return truncated; }
+
+    bool writeMessage(const Message &message, int depth) {
+        const auto plan = printer.findPlan(message.GetDescriptor());
+        if (plan == nullptr) {
+            return false;
+        }
+        const auto reflection = message.GetReflection();
+
+        bool empty = true;
+        out.append(QLatin1Char('{'));
+        for (const auto &fieldPlan : plan->fields) {
+            const auto field = fieldPlan.field;
+            // always_print_primitive_fieldsでも、値の無いメッセージは出力しない
+            if (!field->is_repeated() && field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+                !reflection->HasField(message, field)) {
+                continue;
+            }
+            if (!writeMember(message, *reflection, fieldPlan, depth, empty)) {
+                return false;
+            }
+            if (truncated) {
+                return true;
+            }
+        }
+        for (const auto &fieldPlan : plan->presenceFields) {
+            if (!reflection->HasField(message, fieldPlan.field)) {
+                continue;
+            }
+            if (!writeMember(message, *reflection, fieldPlan, depth, empty)) {
+                return false;
+            }
+            if (truncated) {
+                return true;
+            }
+        }
+        if (!empty) {
+            newline(depth);
+        }
+        out.append(QLatin1Char('}'));
+        return true;
+    }
+
+private:
+    const JsonMessagePrinter &printer;
+    QString &out;
+    const int maxLength;
+    bool truncated = false;
+    QString indent;
+    std::string scratch;
+
+    void newline(int depth) {
+        if (indent.size() < depth) {
+            indent.fill(QLatin1Char(' '), depth * 2);
+        }
+        out.append(QLatin1Char('\n'));
+        out.append(indent.constData(), depth);
+    }
+
+    void writeAscii(const char *text, size_t length) { out.append(QLatin1String(text, static_cast<int>(length))); }
+
+    void checkLength() {
+        if (out.size() > maxLength) {
+            truncated = true;
+        }
+    }
+
+    bool writeMember(const Message &message, const Reflection &reflection, const FieldPlan &fieldPlan, int depth,
+                     bool &empty) {
+        if (!empty) {
+            out.append(QLatin1Char(','));
+        }
+        empty = false;
+        newline(depth + 1);
+        out.append(fieldPlan.key);
+        if (!writeField(message, reflection, fieldPlan.field, depth + 1)) {
+            return false;
+        }
+        checkLength();
+        return true;
+    }
+
+    bool writeField(const Message &message, const Reflection &reflection, const FieldDescriptor *field, int depth) {
+        if (field->is_map()) {
+            return writeMap(message, reflection, field, depth);
+        }
+        if (!field->is_repeated()) {
+            return writeValue(message, reflection, field, -1, depth);
+        }
+
+        const int size = reflection.FieldSize(message, field);
+        if (size == 0) {
+            writeAscii("[]", 2);
+            return true;
+        }
+        out.append(QLatin1Char('['));
+        for (int i = 0; i < size; i++) {
+            if (i > 0) {
+                out.append(QLatin1Char(','));
+            }
+            newline(depth + 1);
+            if (!writeValue(message, reflection, field, i, depth + 1)) {
+                return false;
+            }
+            checkLength();
+            if (truncated) {
+                return true;
+            }
+        }
+        newline(depth);
+        out.append(QLatin1Char(']'));
+        return true;
+    }
+
+    bool writeMap(const Message &message, const Reflection &reflection, const FieldDescriptor *field, int depth) {
+        const int size = reflection.FieldSize(message, field);
+        if (size == 0) {
+            writeAscii("{}", 2);
+            return true;
+        }
+
+        const auto keyField = field->message_type()->map_key();
+        const auto valueField = field->message_type()->map_value();
+        out.append(QLatin1Char('{'));
+        for (int i = 0; i < size; i++) {
+            const auto &entry = reflection.GetRepeatedMessage(message, field, i);
+            const auto entryReflection = entry.GetReflection();
+            if (i > 0) {
+                out.append(QLatin1Char(','));
+            }
+            newline(depth + 1);
+            if (!writeMapKey(entry, *entryReflection, keyField)) {
+                return false;
+            }
+            writeAscii(": ", 2);
+            if (!writeValue(entry, *entryReflection, valueField, -1, depth + 1)) {
+                return false;
+            }
+            checkLength();
+            if (truncated) {
+                return true;
+            }
+        }
+        newline(depth);
+        out.append(QLatin1Char('}'));
+        return true;
+    }
+
+    bool writeMapKey(const Message &entry, const Reflection &reflection, const FieldDescriptor *field) {
+        switch (field->cpp_type()) {
+            case FieldDescriptor::CPPTYPE_STRING:
+                return writeString(reflection.GetStringReference(entry, field, &scratch));
+            case FieldDescriptor::CPPTYPE_BOOL:
+                if (reflection.GetBool(entry, field)) {
+                    writeAscii("\"true\"", 6);
+                } else {
+                    writeAscii("\"false\"", 7);
+                }
+                return true;
+            case FieldDescriptor::CPPTYPE_INT32:
+                writeInteger(reflection.GetInt32(entry, field), true);
+                return true;
+            case FieldDescriptor::CPPTYPE_INT64:
+                writeInteger(reflection.GetInt64(entry, field), true);
+                return true;
+            case FieldDescriptor::CPPTYPE_UINT32:
+                writeInteger(reflection.GetUInt32(entry, field), true);
+                return true;
+            case FieldDescriptor::CPPTYPE_UINT64:
+                writeInteger(reflection.GetUInt64(entry, field), true);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * indexが負ならsingularの値を書く
+     */
+    bool writeValue(const Message &message, const Reflection &reflection, const FieldDescriptor *field, int index,
+                    int depth) {
+        const bool repeated = index >= 0;
+        switch (field->cpp_type()) {
+            case FieldDescriptor::CPPTYPE_INT32:
+                writeInteger(repeated ? reflection.GetRepeatedInt32(message, field, index)
+                                      : reflection.GetInt32(message, field),
+                             false);
+                return true;
+            case FieldDescriptor::CPPTYPE_INT64:
+                writeInteger(repeated ? reflection.GetRepeatedInt64(message, field, index)
+                                      : reflection.GetInt64(message, field),
+                             true);
+                return true;
+            case FieldDescriptor::CPPTYPE_UINT32:
+                writeInteger(repeated ? reflection.GetRepeatedUInt32(message, field, index)
+                                      : reflection.GetUInt32(message, field),
+                             false);
+                return true;
+            case FieldDescriptor::CPPTYPE_UINT64:
+                writeInteger(repeated ? reflection.GetRepeatedUInt64(message, field, index)
+                                      : reflection.GetUInt64(message, field),
+                             true);
+                return true;
+            case FieldDescriptor::CPPTYPE_DOUBLE:
+                writeDouble(repeated ? reflection.GetRepeatedDouble(message, field, index)
+                                     : reflection.GetDouble(message, field));
+                return true;
+            case FieldDescriptor::CPPTYPE_FLOAT:
+                writeFloat(repeated ? reflection.GetRepeatedFloat(message, field, index)
+                                    : reflection.GetFloat(message, field));
+                return true;
+            case FieldDescriptor::CPPTYPE_BOOL:
+                if (repeated ? reflection.GetRepeatedBool(message, field, index) : reflection.GetBool(message, field)) {
+                    writeAscii("true", 4);
+                } else {
+                    writeAscii("false", 5);
+                }
+                return true;
+            case FieldDescriptor::CPPTYPE_ENUM:
+                writeEnum(field->enum_type(), repeated ? reflection.GetRepeatedEnumValue(message, field, index)
+                                                       : reflection.GetEnumValue(message, field));
+                return true;
+            case FieldDescriptor::CPPTYPE_STRING: {
+                const auto &value = repeated ? reflection.GetRepeatedStringReference(message, field, index, &scratch)
+                                             : reflection.GetStringReference(message, field, &scratch);
+                if (field->type() == FieldDescriptor::TYPE_BYTES) {
+                    writeBase64(value);
+                    return true;
+                }
+                return writeString(value);
+            }
+            case FieldDescriptor::CPPTYPE_MESSAGE:
+                return writeMessage(repeated ? reflection.GetRepeatedMessage(message, field, index)
+                                             : reflection.GetMessage(message, field),
+                                    depth);
+        }
+        return false;
+    }
+
+    template <typename T>
+    void writeInteger(T value, bool quoted) {
+        char buffer[24];
+        char *p = buffer;
+        if (quoted) {
+            *p++ = '"';
+        }
+        p = std::to_chars(p, buffer + sizeof(buffer) - 1, value).ptr;
+        if (quoted) {
+            *p++ = '"';
+        }
+        writeAscii(buffer, p - buffer);
+    }
+
+    bool writeNonFinite(double value) {
+        if (std::isnan(value)) {
+            writeAscii("\"NaN\"", 5);
+        } else if (std::isinf(value)) {
+            if (value > 0) {
+                writeAscii("\"Infinity\"", 10);
+            } else {
+                writeAscii("\"-Infinity\"", 11);
+            }
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // 短い桁数で元の値に戻らない場合だけ桁数を増やす (protobufのSimpleDtoa, SimpleFtoaと同じ)
+    void writeDouble(double value) {
+        if (writeNonFinite(value)) {
+            return;
+        }
+        char buffer[40];
+        std::snprintf(buffer, sizeof(buffer), "%.*g", 15, value);
+        delocalizeRadix(buffer);
+        if (parseDouble(buffer) != value) {
+            std::snprintf(buffer, sizeof(buffer), "%.*g", 17, value);
+            delocalizeRadix(buffer);
+        }
+        writeAscii(buffer, std::strlen(buffer));
+    }
+
+    void writeFloat(float value) {
+        if (writeNonFinite(value)) {
+            return;
+        }
+        char buffer[40];
+        std::snprintf(buffer, sizeof(buffer), "%.*g", 6, static_cast<double>(value));
+        // SimpleFtoaはstrtofで読み戻すので、非正規化数 (ERANGE) も桁数を増やす側になる
+        char *end;
+        errno = 0;
+        const float parsed = std::strtof(buffer, &end);
+        if (*end != '\0' || errno != 0 || parsed != value) {
+            std::snprintf(buffer, sizeof(buffer), "%.*g", 9, static_cast<double>(value));
+        }
+        delocalizeRadix(buffer);
+        writeAscii(buffer, std::strlen(buffer));
+    }
+
+    void writeEnum(const EnumDescriptor *type, int number) {
+        const auto value = type->FindValueByNumber(number);
+        if (value == nullptr) {
+            // 未定義の値は数値のまま
+            writeInteger(number, false);
+            return;
+        }
+        out.append(QLatin1Char('"'));
+        writeAscii(value->name().data(), value->name().size());
+        out.append(QLatin1Char('"'));
+    }
+
+    void writeBase64(const std::string &value) {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        out.append(QLatin1Char('"'));
+
+        char buffer[256];
+        size_t length = 0;
+        const auto data = reinterpret_cast<const unsigned char *>(value.data());
+        size_t i = 0;
+        for (; i + 3 <= value.size(); i += 3) {
+            const uint32_t bits = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+            buffer[length++] = alphabet[(bits >> 18) & 0x3f];
+            buffer[length++] = alphabet[(bits >> 12) & 0x3f];
+            buffer[length++] = alphabet[(bits >> 6) & 0x3f];
+            buffer[length++] = alphabet[bits & 0x3f];
+            if (length == sizeof(buffer)) {
+                writeAscii(buffer, length);
+                length = 0;
+            }
+        }
+        if (i < value.size()) {
+            const bool two = i + 1 < value.size();
+            const uint32_t bits = (data[i] << 16) | (two ? data[i + 1] << 8 : 0);
+            buffer[length++] = alphabet[(bits >> 18) & 0x3f];
+            buffer[length++] = alphabet[(bits >> 12) & 0x3f];
+            buffer[length++] = two ? alphabet[(bits >> 6) & 0x3f] : '=';
+            buffer[length++] = '=';
+        }
+        writeAscii(buffer, length);
+
+        out.append(QLatin1Char('"'));
+    }
+
+    void writeUnicodeEscape(uint32_t unit) {
+        static const char hex[] = "0123456789abcdef";
+        const char escape[] = {'\\', 'u', hex[(unit >> 12) & 0xf], hex[(unit >> 8) & 0xf], hex[(unit >> 4) & 0xf],
+                               hex[unit & 0xf]};
+        writeAscii(escape, sizeof(escape));
+    }
+
+    /**
+     * UTF-8からUTF-16へ変換しながらエスケープする
+     */
+    bool writeString(const std::string &value) {
+        out.append(QLatin1Char('"'));
+        const char *p = value.data();
+        const char *end = p + value.size();
+        while (p < end) {
+            const char *run = p;
+            while (p < end && isPlainAscii(*p)) {
+                p++;
+            }
+            if (p > run) {
+                writeAscii(run, p - run);
+            }
+            if (p >= end) {
+                break;
+            }
+
+            const auto c = static_cast<unsigned char>(*p);
+            if (c < 0x80) {
+                p++;
+                switch (c) {
+                    case '"':
+                        writeAscii("\\\"", 2);
+                        break;
+                    case '\\':
+                        writeAscii("\\\\", 2);
+                        break;
+                    case '\b':
+                        writeAscii("\\b", 2);
+                        break;
+                    case '\t':
+                        writeAscii("\\t", 2);
+                        break;
+                    case '\n':
+                        writeAscii("\\n", 2);
+                        break;
+                    case '\f':
+                        writeAscii("\\f", 2);
+                        break;
+                    case '\r':
+                        writeAscii("\\r", 2);
+                        break;
+                    default:
+                        writeUnicodeEscape(c);
+                        break;
+                }
+                continue;
+            }
+
+            uint32_t codePoint;
+            const auto length = decodeUtf8(p, end, codePoint);
+            if (length == 0) {
+                return false;
+            }
+            p += length;
+
+            if (codePoint < 0x10000) {
+                if (needsEscape(codePoint)) {
+                    writeUnicodeEscape(codePoint);
+                } else {
+                    out.append(QChar(static_cast<ushort>(codePoint)));
+                }
+            } else {
+                const uint32_t high = 0xd800 + ((codePoint - 0x10000) >> 10);
+                const uint32_t low = 0xdc00 + ((codePoint - 0x10000) & 0x3ff);
+                if (needsEscape(codePoint)) {
+                    writeUnicodeEscape(high);
+                    writeUnicodeEscape(low);
+                } else {
+                    out.append(QChar(static_cast<ushort>(high)));
+                    out.append(QChar(static_cast<ushort>(low)));
+                }
+            }
+        }
+        out.append(QLatin1Char('"'));
+        return true;
+    }
+};
+
+JsonMessagePrinter::JsonMessagePrinter(const Descriptor *descriptor) : descriptor(descriptor) { compile(descriptor); }
+
+bool JsonMessagePrinter::print(const Message &message, QString &out, int maxLength, bool &truncated) const {
+    if (message.GetDescriptor() != descriptor) {
+        return false;
+    }
+
+    out.clear();
+    // 出力はワイヤーフォーマットより大きくなることが多いので、多めに確保しておく
+    out.reserve(static_cast<int>(std::min<size_t>(message.ByteSizeLong() * 3 + 256, size_t(maxLength) + 256)));
+
+    Writer writer(*this, out, maxLength);
+    if (!writer.writeMessage(message, 0)) {
+        return false;
+    }
+    out.append(QLatin1Char('\n'));
+    truncated = writer.isTruncated() || out.size() > maxLength;
+    if (truncated) {
+        out.truncate(maxLength);
+    }
+    return true;
+}
+
+void JsonMessagePrinter::compile(const Descriptor *message) {
+    // well-known typeは独自のJSON表現を持ち、proto2はデフォルト値の扱いが違うので、汎用の変換に任せる
+    if (plans.count(message) > 0 || isWellKnownType(message) ||
+        message->file()->syntax() != FileDescriptor::SYNTAX_PROTO3) {
+        return;
+    }
+
+    auto &plan = plans[message];
+    for (int i = 0; i < message->field_count(); i++) {
+        const auto field = message->field(i);
+        FieldPlan fieldPlan{field, QString::fromStdString("\"" + field->json_name() + "\": ")};
+        // メッセージ型は値があるときだけ出力されるが、位置は宣言順のまま
+        if (field->containing_oneof() != nullptr && field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+            plan.presenceFields.push_back(std::move(fieldPlan));
+        } else {
+            plan.fields.push_back(std::move(fieldPlan));
+        }
+    }
+    std::sort(plan.presenceFields.begin(), plan.presenceFields.end(),
+              [](const FieldPlan &a, const FieldPlan &b) { return a.field->number() < b.field->number(); });
+
+    for (int i = 0; i < message->field_count(); i++) {
+        if (const auto child = message->field(i)->message_type()) {
+            compile(child);
+        }
+    }
+}
+
+const JsonMessagePrinter::MessagePlan *JsonMessagePrinter::findPlan(const Descriptor *message) const {
+    const auto found = plans.find(message);
+    return found != plans.end() ? &found->second : nullptr;
+}
@@ -0,0 +1,49 @@
+#ifndef FLORARPC_JSONMESSAGEPRINTER_H
+#define FLORARPC_JSONMESSAGEPRINTER_H
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <QString>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Descriptorごとにフィールドの出力順とキーを事前に組み立てて、QStringへ直接JSONを書き出す
+ * MessageToJsonString (add_whitespace, always_print_primitive_fields) と同じ出力になる範囲だけを扱う
+ */
+class JsonMessagePrinter {
+public:
+    explicit JsonMessagePrinter(const google::protobuf::Descriptor *descriptor);
+
+    /**
+     * proto3以外の型や値の入ったwell-known type、不正なUTF-8を含む文字列など、扱えないメッセージではfalseを返す
+     * 出力がmaxLengthを超えた時点で打ち切り、truncatedをtrueにする
+     */
+    bool print(const google::protobuf::Message &message, QString &out, int maxLength, bool &truncated) const;
+
+private:
+    class Writer;
+
+    struct FieldPlan {
+        const google::protobuf::FieldDescriptor *field;
+        // "jsonName": まで
+        QString key;
+    };
+
+    struct MessagePlan {
+        // 宣言順。メッセージ型以外は値が無くても出力される
+        std::vector<FieldPlan> fields;
+        // メッセージ型以外のoneofとproto3 optionalは、値のあるものだけがフィールド番号順に後ろへ付く
+        std::vector<FieldPlan> presenceFields;
+    };
+
+    const google::protobuf::Descriptor *descriptor;
+    std::unordered_map<const google::protobuf::Descriptor *, MessagePlan> plans;
+
+    void compile(const google::protobuf::Descriptor *message);
+
+    const MessagePlan *findPlan(const google::protobuf::Descriptor *message) const;
+};
+
+#endif  // FLORARPC_JSONMESSAGEPRINTER_H
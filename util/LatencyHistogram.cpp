@@ -0,0 +1,138 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <limits>
+
+// 有効数字3桁 (2 * 10^3 を2の冪に切り上げた値)
+static constexpr int SUB_BUCKET_COUNT_MAGNITUDE = 11;
+static constexpr int SUB_BUCKET_HALF_COUNT_MAGNITUDE = SUB_BUCKET_COUNT_MAGNITUDE - 1;
+static constexpr int64_t SUB_BUCKET_COUNT = INT64_C(1) << SUB_BUCKET_COUNT_MAGNITUDE;
+static constexpr int64_t SUB_BUCKET_HALF_COUNT = SUB_BUCKET_COUNT / 2;
+static constexpr int64_t SUB_BUCKET_MASK = SUB_BUCKET_COUNT - 1;
+static constexpr int LEADING_ZERO_COUNT_BASE = 64 - SUB_BUCKET_HALF_COUNT_MAGNITUDE - 1;
+
+static int countLeadingZeros(uint64_t value) {
+    if (value == 0) {
+        return 64;
+    }
+    int count = 0;
+    for (int shift = 32; shift > 0; shift >>= 1) {
+        if ((value >> (64 - shift)) == 0) {
+            count += shift;
+            value <<= shift;
+        }
+    }
+    return count;
+}
+
+static int bucketIndexFor(int64_t value) {
+    return LEADING_ZERO_COUNT_BASE - countLeadingZeros(static_cast<uint64_t>(value | SUB_BUCKET_MASK));
+}
+
+LatencyHistogram::LatencyHistogram(int64_t highestTrackableValue)
+    : highestTrackableValue(std::max(highestTrackableValue, SUB_BUCKET_COUNT)), totalCount(0), minValue(0),
+      maxValue(0) {
+    int64_t smallestUntrackableValue = SUB_BUCKET_COUNT;
+    bucketCount = 1;
+    while (smallestUntrackableValue <= this->highestTrackableValue) {
+        if (smallestUntrackableValue > std::numeric_limits<int64_t>::max() / 2) {
+            bucketCount++;
+            break;
+        }
+        smallestUntrackableValue <<= 1;
+        bucketCount++;
+    }
+    countsLength = static_cast<int>((bucketCount + 1) * SUB_BUCKET_HALF_COUNT);
+    counts = std::make_unique<std::atomic<int64_t>[]>(countsLength);
+    reset();
+}
+
+void LatencyHistogram::record(int64_t value) {
+    value = std::clamp<int64_t>(value, 0, highestTrackableValue);
+    counts[countsIndexFor(value)].fetch_add(1, std::memory_order_relaxed);
+    totalCount.fetch_add(1, std::memory_order_relaxed);
+
+    auto min = minValue.load(std::memory_order_relaxed);
+    while (value < min && !minValue.compare_exchange_weak(min, value, std::memory_order_relaxed)) {
+    }
+    auto max = maxValue.load(std::memory_order_relaxed);
+    while (value > max && !maxValue.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (int i = 0; i < countsLength; i++) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    totalCount.store(0);
+    minValue.store(std::numeric_limits<int64_t>::max());
+    maxValue.store(0);
+}
+
+int64_t LatencyHistogram::getTotalCount() const { return totalCount.load(std::memory_order_relaxed); }
+
+int64_t LatencyHistogram::getMin() const {
+    return getTotalCount() == 0 ? 0 : minValue.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::getMax() const { return maxValue.load(std::memory_order_relaxed); }
+
+double LatencyHistogram::getMean() const {
+    int64_t total = 0;
+    double sum = 0;
+    for (int i = 0; i < countsLength; i++) {
+        const auto count = counts[i].load(std::memory_order_relaxed);
+        if (count != 0) {
+            total += count;
+            sum += static_cast<double>(count) * static_cast<double>(valueFromIndex(i));
+        }
+    }
+    return total == 0 ? 0 : sum / static_cast<double>(total);
+}
+
+int64_t LatencyHistogram::getValueAtPercentile(double percentile) const {
+    int64_t total = 0;
+    for (int i = 0; i < countsLength; i++) {
+        total += counts[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    const auto countAtPercentile =
+        std::max<int64_t>(1, static_cast<int64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5));
+    int64_t cumulative = 0;
+    for (int i = 0; i < countsLength; i++) {
+        cumulative += counts[i].load(std::memory_order_relaxed);
+        if (cumulative >= countAtPercentile) {
+            return std::min(highestEquivalentValue(valueFromIndex(i)), getMax());
+        }
+    }
+    return getMax();
+}
+
+int LatencyHistogram::countsIndexFor(int64_t value) const {
+    const auto bucketIndex = bucketIndexFor(value);
+    const auto subBucketIndex = value >> bucketIndex;
+    return static_cast<int>(((static_cast<int64_t>(bucketIndex) + 1) << SUB_BUCKET_HALF_COUNT_MAGNITUDE) +
+                            (subBucketIndex - SUB_BUCKET_HALF_COUNT));
+}
+
+int64_t LatencyHistogram::valueFromIndex(int index) const {
+    int bucketIndex = (index >> SUB_BUCKET_HALF_COUNT_MAGNITUDE) - 1;
+    int64_t subBucketIndex = (index & (SUB_BUCKET_HALF_COUNT - 1)) + SUB_BUCKET_HALF_COUNT;
+    if (bucketIndex < 0) {
+        subBucketIndex -= SUB_BUCKET_HALF_COUNT;
+        bucketIndex = 0;
+    }
+    return subBucketIndex << bucketIndex;
+}
+
+int64_t LatencyHistogram::highestEquivalentValue(int64_t value) const {
+    const auto bucketIndex = bucketIndexFor(value);
+    const auto subBucketIndex = value >> bucketIndex;
+    const auto adjustedBucket = subBucketIndex >= SUB_BUCKET_COUNT ? bucketIndex + 1 : bucketIndex;
+    const auto lowestEquivalentValue = subBucketIndex << bucketIndex;
+    return lowestEquivalentValue + (INT64_C(1) << adjustedBucket) - 1;
+}
@@ -0,0 +1,56 @@
+#ifndef FLORARPC_LATENCYHISTOGRAM_H
+#define FLORARPC_LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * HdrHistogramと同じバケット構成で、有効数字3桁の精度でレイテンシを記録するヒストグラム。
+ * recordは複数スレッドからロック無しで呼び出せる。
+ */
+class LatencyHistogram {
+public:
+    /**
+     * @param highestTrackableValue 記録できる最大値。これを超える値は最大値に丸められる。
+     */
+    explicit LatencyHistogram(int64_t highestTrackableValue);
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(int64_t value);
+
+    void reset();
+
+    int64_t getTotalCount() const;
+
+    int64_t getMin() const;
+
+    int64_t getMax() const;
+
+    double getMean() const;
+
+    /**
+     * @param percentile 0〜100
+     */
+    int64_t getValueAtPercentile(double percentile) const;
+
+private:
+    const int64_t highestTrackableValue;
+    int bucketCount;
+    int countsLength;
+    std::unique_ptr<std::atomic<int64_t>[]> counts;
+    std::atomic<int64_t> totalCount;
+    std::atomic<int64_t> minValue;
+    std::atomic<int64_t> maxValue;
+
+    int countsIndexFor(int64_t value) const;
+
+    int64_t valueFromIndex(int index) const;
+
+    int64_t highestEquivalentValue(int64_t value) const;
+};
+
+#endif  // FLORARPC_LATENCYHISTOGRAM_H
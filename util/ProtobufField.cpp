@@ -0,0 +1,123 @@
+#include "ProtobufField.h"
+
+#include <QByteArray>
+#include <QLocale>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+static void formatNumber(double value, int precision, ProtobufField::ScalarValue &out) {
+    // JSONと同じく、有限でない値は文字列にする
+    if (std::isnan(value)) {
+        out.text = "NaN";
+        out.quoted = true;
+    } else if (std::isinf(value)) {
+        out.text = value > 0 ? "Infinity" : "-Infinity";
+        out.quoted = true;
+    } else {
+        out.text = QByteArray::number(value, 'g', precision).toStdString();
+    }
+}
+
+const FieldDescriptor *ProtobufField::findField(const Descriptor *type, const std::string &name) {
+    if (const auto field = type->FindFieldByName(name)) {
+        return field;
+    }
+    for (int i = 0; i < type->field_count(); i++) {
+        if (type->field(i)->json_name() == name) {
+            return type->field(i);
+        }
+    }
+    return nullptr;
+}
+
+ProtobufField::ScalarValue ProtobufField::formatScalar(const Message &message, const FieldDescriptor *field, int index,
+                                                       size_t maxLength) {
+    const auto reflection = message.GetReflection();
+    const bool repeated = index >= 0;
+    ScalarValue out;
+    switch (field->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_INT32:
+            out.text = std::to_string(repeated ? reflection->GetRepeatedInt32(message, field, index)
+                                               : reflection->GetInt32(message, field));
+            break;
+        case FieldDescriptor::CPPTYPE_INT64:
+            out.text = std::to_string(repeated ? reflection->GetRepeatedInt64(message, field, index)
+                                               : reflection->GetInt64(message, field));
+            break;
+        case FieldDescriptor::CPPTYPE_UINT32:
+            out.text = std::to_string(repeated ? reflection->GetRepeatedUInt32(message, field, index)
+                                               : reflection->GetUInt32(message, field));
+            break;
+        case FieldDescriptor::CPPTYPE_UINT64:
+            out.text = std::to_string(repeated ? reflection->GetRepeatedUInt64(message, field, index)
+                                               : reflection->GetUInt64(message, field));
+            break;
+        case FieldDescriptor::CPPTYPE_DOUBLE:
+            formatNumber(repeated ? reflection->GetRepeatedDouble(message, field, index)
+                                  : reflection->GetDouble(message, field),
+                         QLocale::FloatingPointShortest, out);
+            break;
+        case FieldDescriptor::CPPTYPE_FLOAT: {
+            const float value = repeated ? reflection->GetRepeatedFloat(message, field, index)
+                                         : reflection->GetFloat(message, field);
+            // doubleにすると余計な桁が出るので、floatに戻して同じになる最短の桁数で書く
+            int precision = 6;
+            while (precision < 9 && std::isfinite(value) &&
+                   std::strtof(QByteArray::number(value, 'g', precision).constData(), nullptr) != value) {
+                precision++;
+            }
+            formatNumber(value, precision, out);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_BOOL:
+            out.text = (repeated ? reflection->GetRepeatedBool(message, field, index)
+                                 : reflection->GetBool(message, field))
+                           ? "true"
+                           : "false";
+            break;
+        case FieldDescriptor::CPPTYPE_ENUM: {
+            // GetEnumは定義に無い値にも名前を作ってしまうので、番号から引く
+            const auto number = repeated ? reflection->GetRepeatedEnumValue(message, field, index)
+                                         : reflection->GetEnumValue(message, field);
+            if (const auto value = field->enum_type()->FindValueByNumber(number)) {
+                out.text = value->name();
+                out.quoted = true;
+            } else {
+                out.text = std::to_string(number);
+            }
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_STRING: {
+            std::string scratch;
+            const auto &value = repeated ? reflection->GetRepeatedStringReference(message, field, index, &scratch)
+                                         : reflection->GetStringReference(message, field, &scratch);
+            out.truncated = value.size() > maxLength;
+            const auto size = std::min(value.size(), maxLength);
+            if (field->type() == FieldDescriptor::TYPE_BYTES) {
+                out.text = QByteArray::fromRawData(value.data(), static_cast<int>(size)).toBase64().toStdString();
+            } else {
+                out.text.assign(value.data(), size);
+            }
+            out.quoted = true;
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+            break;
+    }
+    return out;
+}
+
+QString ProtobufField::toDisplayString(const Message &message, const FieldDescriptor *field, int index,
+                                       int maxLength) {
+    const auto value = formatScalar(message, field, index, static_cast<size_t>(maxLength));
+    auto text = QString::fromStdString(value.text);
+    if (field->type() == FieldDescriptor::TYPE_STRING) {
+        text = QString("\"%1\"").arg(text);
+    }
+    return value.truncated ? text + "…" : text;
+}
@@ -0,0 +1,42 @@
+#ifndef FLORARPC_PROTOBUFFIELD_H
+#define FLORARPC_PROTOBUFFIELD_H
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <QString>
+#include <string>
+
+/**
+ * リフレクションでフィールドを扱う処理のうち、索引、書き出し、比較、ツリー表示で共通のもの
+ */
+namespace ProtobufField {
+    /**
+     * フィールド名で、無ければjson_nameで引く。ユーザーが書いたパスの解決に使う
+     */
+    const google::protobuf::FieldDescriptor *findField(const google::protobuf::Descriptor *type,
+                                                       const std::string &name);
+
+    struct ScalarValue {
+        std::string text;
+        // JSONでは文字列として書かれる値。文字列、bytes、名前のある列挙、有限でない浮動小数点数 (64bit整数は含めない)
+        bool quoted = false;
+        // 文字列かbytesを、maxLengthバイトで切った
+        bool truncated = false;
+    };
+
+    /**
+     * メッセージ型以外のフィールドの値を、JSONと同じ表記で文字列にする。indexが負なら繰り返しでないフィールドを読む
+     * 列挙は名前 (定義に無い値は番号)、bytesはBase64にする。文字列は引用符を付けずにそのまま入れる
+     */
+    ScalarValue formatScalar(const google::protobuf::Message &message, const google::protobuf::FieldDescriptor *field,
+                             int index, size_t maxLength = std::string::npos);
+
+    /**
+     * 表の1セルに出す形にする。文字列は引用符で囲み、maxLengthで切った場合は末尾に…を付ける
+     */
+    QString toDisplayString(const google::protobuf::Message &message, const google::protobuf::FieldDescriptor *field,
+                            int index, int maxLength);
+}  // namespace ProtobufField
+
+#endif  // FLORARPC_PROTOBUFFIELD_H
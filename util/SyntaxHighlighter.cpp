@@ -5,24 +5,50 @@
 #include <KSyntaxHighlighting/repository.h>
 #include <KSyntaxHighlighting/theme.h>
 
-std::unique_ptr<KSyntaxHighlighting::SyntaxHighlighter> SyntaxHighlighter::setup(QTextEdit& textEdit, const QPalette &palette) {
+static KSyntaxHighlighting::Repository &repository() {
     static KSyntaxHighlighting::Repository repository;
-    static auto jsonDefinition = repository.definitionForMimeType("application/json");
+    return repository;
+}
 
-    if (!jsonDefinition.isValid()) {
-        return nullptr;
-    }
+static KSyntaxHighlighting::Theme themeFor(const QPalette &palette) {
+    return (palette.color(QPalette::Base).lightness() < 128)
+           ? repository().defaultTheme(KSyntaxHighlighting::Repository::DarkTheme)
+           : repository().defaultTheme(KSyntaxHighlighting::Repository::LightTheme);
+}
 
-    const auto theme = (palette.color(QPalette::Base).lightness() < 128)
-                       ? repository.defaultTheme(KSyntaxHighlighting::Repository::DarkTheme)
-                       : repository.defaultTheme(KSyntaxHighlighting::Repository::LightTheme);
-    auto highlighter = std::make_unique<KSyntaxHighlighting::SyntaxHighlighter>(&textEdit);
+static void applyPalette(QTextEdit &textEdit, const KSyntaxHighlighting::Theme &theme) {
     auto pal = qApp->palette();
     if (theme.isValid()) {
         pal.setColor(QPalette::Base, theme.editorColor(KSyntaxHighlighting::Theme::BackgroundColor));
         pal.setColor(QPalette::Highlight, theme.editorColor(KSyntaxHighlighting::Theme::TextSelection));
     }
     textEdit.setPalette(pal);
+}
+
+static QTextCharFormat formatFor(const KSyntaxHighlighting::Theme &theme, KSyntaxHighlighting::Theme::TextStyle style) {
+    QTextCharFormat format;
+    if (const auto color = theme.textColor(style)) {
+        format.setForeground(QColor::fromRgba(color));
+    }
+    if (theme.isBold(style)) {
+        format.setFontWeight(QFont::Bold);
+    }
+    if (theme.isItalic(style)) {
+        format.setFontItalic(true);
+    }
+    return format;
+}
+
+std::unique_ptr<KSyntaxHighlighting::SyntaxHighlighter> SyntaxHighlighter::setup(QTextEdit& textEdit, const QPalette &palette) {
+    static auto jsonDefinition = repository().definitionForMimeType("application/json");
+
+    if (!jsonDefinition.isValid()) {
+        return nullptr;
+    }
+
+    const auto theme = themeFor(palette);
+    auto highlighter = std::make_unique<KSyntaxHighlighting::SyntaxHighlighter>(&textEdit);
+    applyPalette(textEdit, theme);
 
     highlighter->setDefinition(jsonDefinition);
     highlighter->setTheme(theme);
@@ -30,3 +56,20 @@ std::unique_ptr<KSyntaxHighlighting::SyntaxHighlighter> SyntaxHighlighter::setup
 
     return highlighter;
 }
+
+std::unique_ptr<JsonHighlighter> SyntaxHighlighter::setupIncremental(QTextEdit &textEdit, const QPalette &palette) {
+    const auto theme = themeFor(palette);
+    applyPalette(textEdit, theme);
+
+    // KSyntaxHighlightingのJSON定義と同じスタイルを当てる
+    using Style = KSyntaxHighlighting::Theme::TextStyle;
+    JsonHighlighter::Formats formats;
+    if (theme.isValid()) {
+        formats.key = formatFor(theme, Style::DataType);
+        formats.string = formatFor(theme, Style::String);
+        formats.number = formatFor(theme, Style::DecVal);
+        formats.keyword = formatFor(theme, Style::Keyword);
+        formats.error = formatFor(theme, Style::Error);
+    }
+    return std::make_unique<JsonHighlighter>(textEdit, formats);
+}
@@ -6,9 +6,16 @@
 #include <QTextEdit>
 #include <memory>
 
+#include "JsonHighlighter.h"
+
 class SyntaxHighlighter {
 public:
     static std::unique_ptr<KSyntaxHighlighting::SyntaxHighlighter> setup(QTextEdit &textEdit, const QPalette &palette);
+
+    /**
+     * setupと同じテーマで、見えている範囲だけをハイライトする。大きなドキュメントを扱うエディタ向け
+     */
+    static std::unique_ptr<JsonHighlighter> setupIncremental(QTextEdit &textEdit, const QPalette &palette);
 };
 
 #endif  // FLORARPC_SYNTAXHIGHLIGHTER_H